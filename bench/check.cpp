@@ -0,0 +1,210 @@
+#include "check.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <string>
+
+#include "config.hpp"
+#include "rv_asm.hpp"
+#include "simulator.hpp"
+
+// Счётчик выделений для всего riscv-bench; замеры времени он не задевает,
+// в горячем цикле выделений нет
+static uint64_t g_allocations = 0;
+
+void* operator new(std::size_t size) {
+    g_allocations++;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static constexpr uint64_t CHECK_BATCH = 4096; // N для step(N)
+
+// Подписчик через шаблонный subscribe(Sink&)
+struct CountingSink {
+    uint64_t events = 0;
+    uint64_t hits = 0;
+    uint64_t instr = 0;
+
+    void operator()(std::span<const AccessEvent> batch) {
+        for (const AccessEvent& e : batch) {
+            events++;
+            hits += e.hit;
+            instr += e.type == AccessType::Instruction;
+        }
+    }
+};
+
+static bool same_stats(const CacheStats& a, const CacheStats& b) {
+    return a.instr_access == b.instr_access && a.instr_hit == b.instr_hit &&
+           a.data_access == b.data_access && a.data_hit == b.data_hit &&
+           a.evictions == b.evictions && a.writebacks == b.writebacks &&
+           a.misaligned_access == b.misaligned_access && a.split_access == b.split_access;
+}
+
+static bool check_kernel(const Kernel& k) {
+    std::vector<MemorySegment> image;
+    for (const auto& [addr, data] : k.memory)
+        image.push_back({addr, data});
+
+    bool ok = true;
+    auto fail = [&](const char* what) {
+        std::printf("%-13s FAIL: %s\n", k.name.c_str(), what);
+        ok = false;
+    };
+
+    // эталон: по одной инструкции, без слияния
+    Simulator single(k.registers, image);
+    while (!single.halted())
+        single.step(1);
+
+    // пачки со слиянием, подписчик и memory() посреди прогона
+    Simulator batched(k.registers, image);
+    batched.processor().set_fusion_enabled(true);
+    CountingSink sink;
+    batched.subscribe(sink);
+
+    uint64_t allocations = g_allocations;
+    bool peeked = false;
+
+    while (!batched.halted()) {
+        batched.step(CHECK_BATCH);
+
+        if (!peeked && batched.retired() >= single.retired() / 2) {
+            CacheStats before = batched.stats();
+            batched.memory();
+            if (!same_stats(before, batched.stats()))
+                fail("memory() changed cache stats");
+            peeked = true;
+        }
+    }
+
+    if (g_allocations != allocations)
+        fail("allocations during stepping");
+
+    const CacheStats& s = single.stats();
+    const CacheStats& b = batched.stats();
+
+    if (single.retired() != batched.retired())
+        fail("retired instruction count differs");
+    if (!std::ranges::equal(single.regs(), batched.regs()))
+        fail("registers differ");
+    if (!same_stats(s, b))
+        fail("cache stats differ");
+    if (!std::ranges::equal(single.memory(), batched.memory()))
+        fail("memory differs");
+    if (batched.regs()[10] != k.expected_a0)
+        fail("checksum mismatch");
+    if (s.misaligned_access != k.expected_misaligned || s.split_access != k.expected_split)
+        fail("misaligned/split counts differ from the host model");
+
+    if (sink.events != b.instr_access + b.data_access ||
+        sink.hits != b.instr_hit + b.data_hit ||
+        sink.instr != b.instr_access)
+        fail("sink events do not match cache stats");
+
+    if (ok) {
+        FusionStats f = batched.fusion_stats();
+        std::printf("%-13s ok: %llu instructions, %llu fused pairs, %llu events, %llu split\n",
+                    k.name.c_str(),
+                    (unsigned long long)batched.retired(),
+                    (unsigned long long)(f.lui_addi + f.auipc_jalr + f.cmp_branch + f.slli_add),
+                    (unsigned long long)sink.events,
+                    (unsigned long long)b.split_access);
+    }
+    return ok;
+}
+
+// Sv32: lw, sw, lw через границу двух страниц данных. Первый lw обходит
+// таблицу для обеих страниц, sw обходит её ещё раз ради бита D, второй lw
+// попадает в D-TLB. Плюс один обход для страницы кода.
+static bool check_sv32() {
+    constexpr uint32_t ROOT = 0x30000, LEAVES = ROOT + PAGE_SIZE;
+    constexpr uint32_t DATA_VA = 0x10000 + PAGE_SIZE - 2; // 2 байта на одной странице, 2 на другой
+    constexpr uint32_t PAGE_LO = 0x20000, PAGE_HI = 0x25000; // физически не подряд
+    constexpr uint32_t STORED = 0xA1B2C3D4;
+
+    auto pte = [](uint32_t pa, uint32_t flags) { return (pa >> PAGE_OFFSET_LEN) << 10 | flags; };
+    constexpr uint32_t V = 0x1, R = 0x2, W = 0x4, X = 0x8;
+
+    std::vector<uint8_t> root(4), leaves(PAGE_SIZE);
+    auto put32 = [](std::vector<uint8_t>& v, uint32_t off, uint32_t w) {
+        for (int b = 0; b < 4; ++b) v[off + b] = uint8_t(w >> (8 * b));
+    };
+    put32(root, 0, pte(LEAVES, V));
+    put32(leaves, 0, pte(0, R | X | V));
+    put32(leaves, (DATA_VA >> PAGE_OFFSET_LEN) * 4, pte(PAGE_LO, R | W | V));
+    put32(leaves, ((DATA_VA >> PAGE_OFFSET_LEN) + 1) * 4, pte(PAGE_HI, R | W | V));
+
+    const std::vector<uint8_t> lo = {0x11, 0x22}, hi = {0x33, 0x44};
+
+    Asm a;
+    a.li(s0, DATA_VA); a.li(t1, STORED);
+    a.lw(t0, 0, s0); a.sw(t1, 0, s0); a.lw(t2, 0, s0);
+    a.add(a0, t0, t2);
+    a.ebreak();
+    std::vector<uint8_t> code = a.finish();
+
+    std::vector<uint32_t> regs(32, 0);
+    regs[1] = PAGE_SIZE - 4; // pc остановки внутри отображённой страницы кода
+
+    const MemorySegment image[] = {
+        {0, code}, {ROOT, root}, {LEAVES, leaves},
+        {PAGE_LO + PAGE_SIZE - 2, lo}, {PAGE_HI, hi},
+    };
+
+    Simulator sim(regs, image);
+    sim.enable_mmu(ROOT);
+    while (!sim.halted())
+        sim.step(CHECK_BATCH);
+
+    bool ok = true;
+    auto fail = [&](const char* what) {
+        std::printf("%-13s FAIL: %s\n", "sv32", what);
+        ok = false;
+    };
+
+    const Mmu& mmu = *sim.mmu();
+    std::span<const uint8_t> mem = sim.memory();
+
+    if (sim.regs()[10] != 0x44332211 + STORED)
+        fail("loaded values differ");
+    if (mem[PAGE_LO + PAGE_SIZE - 2] != 0xD4 || mem[PAGE_LO + PAGE_SIZE - 1] != 0xC3 ||
+        mem[PAGE_HI] != 0xB2 || mem[PAGE_HI + 1] != 0xA1)
+        fail("stored bytes differ");
+    if (mmu.walk_stats().walks != 5)
+        fail("page walk count differs from 5");
+    if (mmu.dtlb().stats().lookups != 6 || mmu.dtlb().stats().hits != 4)
+        fail("D-TLB hits differ from 4 of 6");
+    if (sim.stats().misaligned_access != 3 || sim.stats().split_access != 3)
+        fail("page-crossing accesses are not counted as split");
+
+    if (ok) {
+        std::printf("%-13s ok: %llu walks, D-TLB %llu/%llu hits\n", "sv32",
+                    (unsigned long long)mmu.walk_stats().walks,
+                    (unsigned long long)mmu.dtlb().stats().hits,
+                    (unsigned long long)mmu.dtlb().stats().lookups);
+    }
+    return ok;
+}
+
+uint32_t run_checks(const std::vector<Kernel>& kernels) {
+    uint32_t failed = 0;
+    for (const Kernel& k : kernels) {
+        if (!check_kernel(k)) failed++;
+    }
+    if (!check_sv32()) failed++;
+    return failed;
+}
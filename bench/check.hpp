@@ -0,0 +1,14 @@
+#pragma once // check.hpp
+
+#include <cstdint>
+#include <vector>
+
+#include "kernels.hpp"
+
+// Проверки встраиваемого API на ядрах бенчмарка (riscv-bench --check):
+// step(1) и step(N) дают одинаковые регистры, память и статистику,
+// подписчик видит каждое обращение, шаги не выделяют память,
+// memory() посреди прогона не меняет статистику. Отдельно - Sv32 с
+// обращениями через границу страниц (число обходов и попаданий в D-TLB).
+// Возвращает число проваленных ядер.
+uint32_t run_checks(const std::vector<Kernel>& kernels);
@@ -0,0 +1,329 @@
+#include "kernels.hpp"
+
+#include <algorithm>
+
+#include "config.hpp"
+#include "rv_asm.hpp"
+
+static constexpr uint32_t CODE_ADDR = 0x0;
+static constexpr uint32_t DATA_ADDR = 0x10000;
+static constexpr uint32_t HALT_ADDR = MEMORY_SIZE - 4; // ra на старте, до него не доходим (ebreak)
+
+static std::vector<uint8_t> to_bytes(const std::vector<uint32_t>& words) {
+    std::vector<uint8_t> bytes(words.size() * 4);
+    for (size_t k = 0; k < words.size(); ++k)
+        for (int b = 0; b < 4; ++b)
+            bytes[k * 4 + b] = uint8_t(words[k] >> (8 * b));
+    return bytes;
+}
+
+static Kernel make_kernel(const char* name, Asm& a, uint32_t expected_a0) {
+    Kernel k;
+    k.name = name;
+    k.registers.assign(32, 0);
+    k.registers[0] = CODE_ADDR;
+    k.registers[1] = HALT_ADDR;
+    k.registers[2] = HALT_ADDR & ~0xFu;
+    k.memory[CODE_ADDR] = a.finish();
+    k.expected_a0 = expected_a0;
+    return k;
+}
+
+// C = A * B, матрицы 32x32 int32 (3 * 4 КБ, больше кеша)
+static Kernel matmul(uint32_t reps) {
+    constexpr uint32_t N = 32;
+    constexpr uint32_t A = DATA_ADDR, B = A + N * N * 4, C = B + N * N * 4;
+
+    std::vector<uint32_t> ma(N * N), mb(N * N);
+    for (uint32_t i = 0; i < N; ++i) {
+        for (uint32_t j = 0; j < N; ++j) {
+            ma[i * N + j] = uint32_t(int32_t((i + 2 * j) % 7) - 3);
+            mb[i * N + j] = uint32_t(int32_t((3 * i + j) % 5) - 2);
+        }
+    }
+
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < N; ++i)
+        for (uint32_t j = 0; j < N; ++j)
+            for (uint32_t k = 0; k < N; ++k)
+                sum += ma[i * N + k] * mb[k * N + j];
+
+    Asm a;
+    a.li(s0, A); a.li(s1, B); a.li(s2, C);
+    a.li(s3, N); a.li(s4, N * 4); a.li(s5, reps); a.li(a0, 0);
+    a.label("rep");
+    a.li(t0, 0);
+    a.label("i");
+    a.li(t1, 0);
+    a.label("j");
+    a.li(t2, 0); a.li(t3, 0);
+    a.mul(t4, t0, s4); a.add(t4, t4, s0);
+    a.slli(t5, t1, 2); a.add(t5, t5, s1);
+    a.label("k");
+    a.lw(a1, 0, t4); a.lw(a2, 0, t5); a.mul(a1, a1, a2); a.add(t3, t3, a1);
+    a.addi(t4, t4, 4); a.add(t5, t5, s4); a.addi(t2, t2, 1); a.blt(t2, s3, "k");
+    a.mul(a3, t0, s4); a.slli(a4, t1, 2); a.add(a3, a3, a4); a.add(a3, a3, s2);
+    a.sw(t3, 0, a3); a.add(a0, a0, t3);
+    a.addi(t1, t1, 1); a.blt(t1, s3, "j");
+    a.addi(t0, t0, 1); a.blt(t0, s3, "i");
+    a.addi(s5, s5, -1); a.bnez(s5, "rep");
+    a.ebreak();
+
+    Kernel k = make_kernel("matmul", a, sum * reps);
+    k.memory[A] = to_bytes(ma);
+    k.memory[B] = to_bytes(mb);
+    return k;
+}
+
+// пословное копирование 16 КБ
+static Kernel memcpy_kernel(uint32_t reps) {
+    constexpr uint32_t WORDS = 4096;
+    constexpr uint32_t SRC = DATA_ADDR, DST = SRC + 2 * WORDS * 4;
+
+    std::vector<uint32_t> src(WORDS);
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < WORDS; ++i) {
+        src[i] = i * 2654435761u;
+        sum += src[i];
+    }
+
+    Asm a;
+    a.li(s0, SRC); a.li(s1, DST); a.li(s2, WORDS * 4); a.li(s5, reps); a.li(a0, 0);
+    a.label("rep");
+    a.mv(t0, s0); a.mv(t1, s1); a.add(t2, s0, s2);
+    a.label("copy");
+    a.lw(t3, 0, t0); a.sw(t3, 0, t1); a.add(a0, a0, t3);
+    a.addi(t0, t0, 4); a.addi(t1, t1, 4); a.bne(t0, t2, "copy");
+    a.addi(s5, s5, -1); a.bnez(s5, "rep");
+    a.ebreak();
+
+    Kernel k = make_kernel("memcpy", a, sum * reps);
+    k.memory[SRC] = to_bytes(src);
+    return k;
+}
+
+// обход списка из 4096 узлов, разбросанных по 128 КБ в случайном порядке
+static Kernel list_walk(uint32_t reps) {
+    constexpr uint32_t NODES = 4096, SLOT = 32;
+
+    std::vector<uint32_t> order(NODES);
+    for (uint32_t i = 0; i < NODES; ++i) order[i] = i;
+    uint32_t x = 0xC0FFEE;
+    for (uint32_t i = NODES - 1; i > 0; --i) {
+        x = x * 1664525u + 1013904223u;
+        std::swap(order[i], order[(x >> 8) % (i + 1)]);
+    }
+
+    std::vector<uint32_t> slots(NODES * SLOT / 4, 0);
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < NODES; ++i) {
+        uint32_t word = order[i] * SLOT / 4;
+        slots[word] = i + 1 < NODES ? DATA_ADDR + order[i + 1] * SLOT : 0;
+        slots[word + 1] = i * 3 + 1;
+        sum += i * 3 + 1;
+    }
+
+    Asm a;
+    a.li(s0, DATA_ADDR + order[0] * SLOT); a.li(s5, reps); a.li(a0, 0);
+    a.label("rep");
+    a.mv(t0, s0);
+    a.label("walk");
+    a.lw(t1, 4, t0); a.add(a0, a0, t1); a.lw(t0, 0, t0); a.bnez(t0, "walk");
+    a.addi(s5, s5, -1); a.bnez(s5, "rep");
+    a.ebreak();
+
+    Kernel k = make_kernel("list_walk", a, sum * reps);
+    k.memory[DATA_ADDR] = to_bytes(slots);
+    return k;
+}
+
+// проходы по 64 КБ с шагом 64 байта (через строку), 16 сдвигов
+static Kernel strided(uint32_t reps) {
+    constexpr uint32_t WORDS = 16384, STRIDE = 64;
+
+    std::vector<uint32_t> arr(WORDS);
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < WORDS; ++i) {
+        arr[i] = i ^ (i << 7);
+        sum += arr[i];
+    }
+
+    Asm a;
+    a.li(s0, DATA_ADDR); a.li(s1, DATA_ADDR + WORDS * 4); a.li(s5, reps); a.li(a0, 0);
+    a.label("rep");
+    a.li(t0, 0);
+    a.label("off");
+    a.add(t1, s0, t0);
+    a.label("pass");
+    a.lw(t2, 0, t1); a.add(a0, a0, t2); a.addi(t1, t1, STRIDE); a.bltu(t1, s1, "pass");
+    a.addi(t0, t0, 4); a.li(t3, STRIDE); a.bltu(t0, t3, "off");
+    a.addi(s5, s5, -1); a.bnez(s5, "rep");
+    a.ebreak();
+
+    Kernel k = make_kernel("strided", a, sum * reps);
+    k.memory[DATA_ADDR] = to_bytes(arr);
+    return k;
+}
+
+// lower_bound по отсортированному массиву из 8192 слов, ключи из LCG
+static Kernel binary_search(uint32_t queries) {
+    constexpr uint32_t M = 8192;
+    constexpr uint32_t SEED = 0x12345678, MUL = 1103515245, INC = 12345;
+
+    std::vector<uint32_t> arr(M);
+    for (uint32_t i = 0; i < M; ++i) arr[i] = 2 * i + 1;
+
+    uint32_t sum = 0, x = SEED;
+    for (uint32_t q = 0; q < queries; ++q) {
+        x = x * MUL + INC;
+        uint32_t key = (x >> 8) & (2 * M - 1);
+        sum += uint32_t(std::lower_bound(arr.begin(), arr.end(), key) - arr.begin());
+    }
+
+    Asm a;
+    a.li(s0, DATA_ADDR); a.li(s1, M); a.li(s5, queries);
+    a.li(s6, SEED); a.li(s7, MUL); a.li(s8, 2 * M - 1); a.li(s9, INC); a.li(a0, 0);
+    a.label("query");
+    a.mul(s6, s6, s7); a.add(s6, s6, s9);
+    a.srli(t0, s6, 8); a.and_(t0, t0, s8);
+    a.li(t1, 0); a.mv(t2, s1);
+    a.label("search");
+    a.bge(t1, t2, "done");
+    a.add(t3, t1, t2); a.srli(t3, t3, 1);
+    a.slli(t4, t3, 2); a.add(t4, t4, s0); a.lw(t5, 0, t4);
+    a.bltu(t5, t0, "lower");
+    a.mv(t2, t3); a.j("search");
+    a.label("lower");
+    a.addi(t1, t3, 1); a.j("search");
+    a.label("done");
+    a.add(a0, a0, t1);
+    a.addi(s5, s5, -1); a.bnez(s5, "query");
+    a.ebreak();
+
+    Kernel k = make_kernel("binary_search", a, sum);
+    k.memory[DATA_ADDR] = to_bytes(arr);
+    return k;
+}
+
+// интерпретатор байткода с диспетчеризацией цепочкой сравнений
+static Kernel interpreter(uint32_t iterations) {
+    enum Op : uint32_t { ADD, XOR, MUL3, SHR1, SKIP_IF_ODD, LOOP, HALT };
+    const std::vector<uint32_t> bytecode = {
+        ADD, 7,
+        SKIP_IF_ODD, 0,
+        MUL3, 0,
+        XOR, 0x5A5A,
+        SHR1, 0,
+        SKIP_IF_ODD, 0,
+        ADD, 13,
+        LOOP, 0,
+        HALT, 0,
+    };
+
+    uint32_t acc = 0, counter = iterations, vpc = 0;
+    for (bool running = true; running; ) {
+        uint32_t op = bytecode[vpc * 2], arg = bytecode[vpc * 2 + 1];
+        vpc++;
+        switch (op) {
+            case ADD: acc += arg; break;
+            case XOR: acc ^= arg; break;
+            case MUL3: acc *= 3; break;
+            case SHR1: acc >>= 1; break;
+            case SKIP_IF_ODD: if (acc & 1) vpc++; break;
+            case LOOP: if (--counter) vpc = arg; break;
+            default: running = false; break;
+        }
+    }
+
+    Asm a;
+    a.li(s0, DATA_ADDR); a.li(s1, iterations); a.li(a0, 0); a.li(t0, 0);
+    a.label("dispatch");
+    a.slli(t1, t0, 3); a.add(t1, t1, s0); a.lw(t2, 0, t1); a.lw(t3, 4, t1); a.addi(t0, t0, 1);
+    a.beqz(t2, "op_add");
+    a.li(t4, XOR); a.beq(t2, t4, "op_xor");
+    a.li(t4, MUL3); a.beq(t2, t4, "op_mul3");
+    a.li(t4, SHR1); a.beq(t2, t4, "op_shr1");
+    a.li(t4, SKIP_IF_ODD); a.beq(t2, t4, "op_skip");
+    a.li(t4, LOOP); a.beq(t2, t4, "op_loop");
+    a.ebreak();
+    a.label("op_add");
+    a.add(a0, a0, t3); a.j("dispatch");
+    a.label("op_xor");
+    a.xor_(a0, a0, t3); a.j("dispatch");
+    a.label("op_mul3");
+    a.slli(t4, a0, 1); a.add(a0, a0, t4); a.j("dispatch");
+    a.label("op_shr1");
+    a.srli(a0, a0, 1); a.j("dispatch");
+    a.label("op_skip");
+    a.andi(t4, a0, 1); a.beqz(t4, "dispatch"); a.addi(t0, t0, 1); a.j("dispatch");
+    a.label("op_loop");
+    a.addi(s1, s1, -1); a.beqz(s1, "dispatch"); a.mv(t0, t3); a.j("dispatch");
+
+    Kernel k = make_kernel("interpreter", a, acc);
+    k.memory[DATA_ADDR] = to_bytes(bytecode);
+    return k;
+}
+
+// невыровненные lw/lh/sw с шагом 7 байт по 8 КБ: часть обращений
+// пересекает строку кеша и идёт двумя поисками
+static Kernel unaligned(uint32_t reps) {
+    constexpr uint32_t SIZE = 8192, STEP = 7;
+    constexpr uint32_t END = DATA_ADDR + SIZE - 8;
+
+    std::vector<uint8_t> buf(SIZE);
+    for (uint32_t i = 0; i < SIZE; ++i)
+        buf[i] = uint8_t(i * 37 + (i >> 8));
+
+    std::vector<uint8_t> mem = buf;
+    auto at = [&](uint32_t addr) -> uint8_t& { return mem[addr - DATA_ADDR]; };
+
+    uint64_t misaligned = 0, split = 0;
+    auto count = [&](uint32_t addr, uint32_t size) {
+        misaligned += addr % size != 0;
+        split += addr / CACHE_LINE_SIZE != (addr + size - 1) / CACHE_LINE_SIZE;
+    };
+
+    uint32_t acc = 0;
+    for (uint32_t r = 0; r < reps; ++r) {
+        for (uint32_t p = DATA_ADDR + 1; p < END; p += STEP) {
+            uint32_t w = at(p) | at(p + 1) << 8 | at(p + 2) << 16 | uint32_t(at(p + 3)) << 24;
+            uint32_t h = uint32_t(int32_t(int16_t(at(p + 3) | at(p + 4) << 8)));
+            acc += w + h;
+            uint32_t st = w ^ acc;
+            for (uint32_t b = 0; b < 4; ++b)
+                at(p + 1 + b) = uint8_t(st >> (8 * b));
+            count(p, 4);
+            count(p + 3, 2);
+            count(p + 1, 4);
+        }
+    }
+
+    Asm a;
+    a.li(s0, DATA_ADDR); a.li(s1, END); a.li(s5, reps); a.li(a0, 0);
+    a.label("rep");
+    a.addi(t0, s0, 1);
+    a.label("loop");
+    a.lw(t1, 0, t0); a.lh(t2, 3, t0); a.add(a0, a0, t1); a.add(a0, a0, t2);
+    a.xor_(t3, t1, a0); a.sw(t3, 1, t0);
+    a.addi(t0, t0, STEP); a.bltu(t0, s1, "loop");
+    a.addi(s5, s5, -1); a.bnez(s5, "rep");
+    a.ebreak();
+
+    Kernel k = make_kernel("unaligned", a, acc);
+    k.expected_misaligned = misaligned;
+    k.expected_split = split;
+    k.memory[DATA_ADDR] = buf;
+    return k;
+}
+
+std::vector<Kernel> build_kernels(uint32_t scale) {
+    std::vector<Kernel> kernels;
+    kernels.push_back(matmul(4 * scale));
+    kernels.push_back(memcpy_kernel(40 * scale));
+    kernels.push_back(list_walk(60 * scale));
+    kernels.push_back(strided(16 * scale));
+    kernels.push_back(binary_search(10000 * scale));
+    kernels.push_back(interpreter(12000 * scale));
+    kernels.push_back(unaligned(100 * scale));
+    return kernels;
+}
@@ -0,0 +1,22 @@
+#pragma once // kernels.hpp
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Программа для бенчмарка в том же виде, что и входной файл эмулятора:
+// начальные регистры (x0 = pc) и фрагменты памяти. Результат ядро
+// оставляет в a0, expected_a0 посчитан на хосте. Там же посчитаны
+// невыровненные обращения и обращения через границу строки кеша.
+struct Kernel {
+    std::string name;
+    std::vector<uint32_t> registers;
+    std::map<uint32_t, std::vector<uint8_t>> memory;
+    uint32_t expected_a0 = 0;
+    uint64_t expected_misaligned = 0;
+    uint64_t expected_split = 0;
+};
+
+// scale линейно увеличивает число повторов внутри каждого ядра
+std::vector<Kernel> build_kernels(uint32_t scale);
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "kernels.hpp"
+#include "processor.hpp"
+#include "cache_lru.hpp"
+#include "cache_bplru.hpp"
+#include "ram.hpp"
+#include "config.hpp"
+
+struct BenchResult {
+    std::string kernel;
+    std::string policy;
+    uint64_t instructions = 0;
+    CacheStats stats;
+    double median_s = 0;
+    double min_s = 0;
+    double max_s = 0;
+    bool checksum_ok = false;
+};
+
+struct BenchOptions {
+    uint32_t reps = 5;
+    uint32_t scale = 1;
+    std::string only_kernel;
+    std::string bpred; // пусто - без модели предсказателя
+    bool fusion = false; // --fusion
+    bool json = false;
+    bool check = false; // вместо замеров - проверки Simulator
+};
+
+static void load_memory(RAM& ram, const Kernel& k) {
+    for (const auto& [addr, data] : k.memory) {
+        for (size_t i = 0; i < data.size(); ++i)
+            ram.write8(addr + i, data[i]);
+    }
+}
+
+// Один прогон на свежих RAM/кеше/процессоре; время только Processor::run()
+template <typename Cache>
+static double run_once(const Kernel& k, const BenchOptions& opt,
+                       uint64_t& instructions, CacheStats& stats, bool& ok) {
+    RAM ram(MEMORY_SIZE);
+    load_memory(ram, k);
+
+    Cache cache(ram);
+    Processor cpu(cache, k.registers);
+    cpu.set_fusion_enabled(opt.fusion);
+
+    std::unique_ptr<BranchUnit> branch_unit;
+    if (!opt.bpred.empty()) {
+        branch_unit = std::make_unique<BranchUnit>(make_direction_predictor(opt.bpred), BTB_ENTRIES, RAS_DEPTH);
+        cpu.set_branch_unit(branch_unit.get());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    cpu.run();
+    auto end = std::chrono::steady_clock::now();
+
+    instructions = cpu.retired();
+    stats = cache.stats();
+    ok = cpu.get_reg(10) == k.expected_a0;
+    return std::chrono::duration<double>(end - start).count();
+}
+
+template <typename Cache>
+static BenchResult bench(const Kernel& k, const char* policy, const BenchOptions& opt) {
+    BenchResult r;
+    r.kernel = k.name;
+    r.policy = policy;
+
+    std::vector<double> times;
+    bool ok = false;
+
+    run_once<Cache>(k, opt, r.instructions, r.stats, ok); // прогрев
+    for (uint32_t i = 0; i < opt.reps; ++i)
+        times.push_back(run_once<Cache>(k, opt, r.instructions, r.stats, ok));
+
+    std::sort(times.begin(), times.end());
+    r.min_s = times.front();
+    r.max_s = times.back();
+    r.median_s = times.size() % 2
+        ? times[times.size() / 2]
+        : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+    r.checksum_ok = ok;
+    return r;
+}
+
+static double rate(uint64_t num, uint64_t den) {
+    return den ? 100.0 * num / den : std::nan("");
+}
+
+static void print_table(const std::vector<BenchResult>& results) {
+    std::printf("| kernel        | replacement | instructions |   MIPS   | Macc/s   | hit_rate | instr_hit_rate | data_hit_rate | spread  | ok  |\n");
+    std::printf("| :------------ | :---------- | -----------: | -------: | -------: | -------: | -------------: | ------------: | ------: | :-: |\n");
+
+    for (const BenchResult& r : results) {
+        const CacheStats& s = r.stats;
+        uint64_t accesses = s.instr_access + s.data_access;
+
+        std::printf(
+            "| %-13s | %-11s | %12llu | %8.2f | %8.2f | %7.3f%% |      %8.3f%% |     %8.3f%% | %6.2f%% | %-3s |\n",
+            r.kernel.c_str(),
+            r.policy.c_str(),
+            (unsigned long long)r.instructions,
+            r.instructions / r.median_s / 1e6,
+            accesses / r.median_s / 1e6,
+            rate(s.instr_hit + s.data_hit, accesses),
+            rate(s.instr_hit, s.instr_access),
+            rate(s.data_hit, s.data_access),
+            100.0 * (r.max_s - r.min_s) / r.median_s,
+            r.checksum_ok ? "yes" : "NO"
+        );
+    }
+}
+
+static void print_json(const std::vector<BenchResult>& results, const BenchOptions& opt) {
+    std::printf("{\n  \"benchmark\": \"riscv-bench\",\n  \"reps\": %u,\n  \"scale\": %u,\n  \"results\": [\n",
+                opt.reps, opt.scale);
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        const CacheStats& s = r.stats;
+        uint64_t accesses = s.instr_access + s.data_access;
+
+        std::printf(
+            "    {\"kernel\": \"%s\", \"policy\": \"%s\", \"instructions\": %llu, "
+            "\"median_s\": %.9f, \"min_s\": %.9f, \"max_s\": %.9f, "
+            "\"mips\": %.3f, \"accesses_per_s\": %.1f, "
+            "\"instr_access\": %llu, \"instr_hit\": %llu, \"data_access\": %llu, \"data_hit\": %llu, "
+            "\"misaligned_access\": %llu, \"split_access\": %llu, "
+            "\"hit_rate\": %.6f, \"checksum_ok\": %s}%s\n",
+            r.kernel.c_str(),
+            r.policy.c_str(),
+            (unsigned long long)r.instructions,
+            r.median_s, r.min_s, r.max_s,
+            r.instructions / r.median_s / 1e6,
+            accesses / r.median_s,
+            (unsigned long long)s.instr_access,
+            (unsigned long long)s.instr_hit,
+            (unsigned long long)s.data_access,
+            (unsigned long long)s.data_hit,
+            (unsigned long long)s.misaligned_access,
+            (unsigned long long)s.split_access,
+            accesses ? double(s.instr_hit + s.data_hit) / accesses : 0.0,
+            r.checksum_ok ? "true" : "false",
+            i + 1 < results.size() ? "," : ""
+        );
+    }
+
+    std::printf("  ]\n}\n");
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        BenchOptions opt;
+
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--reps") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing value after --reps");
+                opt.reps = std::stoul(argv[++i]);
+            } else if (arg == "--scale") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing value after --scale");
+                opt.scale = std::stoul(argv[++i]);
+            } else if (arg == "--kernel") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing name after --kernel");
+                opt.only_kernel = argv[++i];
+            } else if (arg == "--bpred") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing predictor after --bpred");
+                opt.bpred = argv[++i];
+            } else if (arg == "--fusion") {
+                opt.fusion = true;
+            } else if (arg == "--json") {
+                opt.json = true;
+            } else if (arg == "--check") {
+                opt.check = true;
+            } else {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+
+        if (opt.reps == 0 || opt.scale == 0)
+            throw std::runtime_error("--reps and --scale must be positive");
+
+        std::vector<Kernel> kernels = build_kernels(opt.scale);
+        if (!opt.only_kernel.empty()) {
+            std::erase_if(kernels, [&](const Kernel& k) { return k.name != opt.only_kernel; });
+            if (kernels.empty())
+                throw std::runtime_error("No kernel named " + opt.only_kernel);
+        }
+
+        if (opt.check) {
+            uint32_t failed = run_checks(kernels);
+            if (failed) {
+                std::cerr << "Error: " << failed << " kernel(s) failed the Simulator checks\n";
+                return 1;
+            }
+            return 0;
+        }
+
+        std::vector<BenchResult> results;
+        bool all_ok = true;
+
+        for (const Kernel& k : kernels) {
+            results.push_back(bench<CacheLRU>(k, "LRU", opt));
+            results.push_back(bench<CacheBpLRU>(k, "bpLRU", opt));
+        }
+
+        for (const BenchResult& r : results)
+            all_ok = all_ok && r.checksum_ok;
+
+        if (opt.json)
+            print_json(results, opt);
+        else
+            print_table(results);
+
+        if (!all_ok) {
+            std::cerr << "Error: kernel checksum mismatch\n";
+            return 1;
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
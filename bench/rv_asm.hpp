@@ -0,0 +1,128 @@
+#pragma once // rv_asm.hpp
+
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Минимальный ассемблер RV32IM для сборки бенчмарков прямо в коде,
+// без внешнего тулчейна. Метки разрешаются в finish().
+
+enum Reg : uint8_t {
+    zero, ra, sp, gp, tp, t0, t1, t2,
+    s0, s1, a0, a1, a2, a3, a4, a5,
+    a6, a7, s2, s3, s4, s5, s6, s7,
+    s8, s9, s10, s11, t3, t4, t5, t6
+};
+
+class Asm {
+public:
+    // R-type
+    void add(Reg rd, Reg rs1, Reg rs2)  { r(0x00, rs2, rs1, 0x0, rd); }
+    void sub(Reg rd, Reg rs1, Reg rs2)  { r(0x20, rs2, rs1, 0x0, rd); }
+    void xor_(Reg rd, Reg rs1, Reg rs2) { r(0x00, rs2, rs1, 0x4, rd); }
+    void or_(Reg rd, Reg rs1, Reg rs2)  { r(0x00, rs2, rs1, 0x6, rd); }
+    void and_(Reg rd, Reg rs1, Reg rs2) { r(0x00, rs2, rs1, 0x7, rd); }
+    void slt(Reg rd, Reg rs1, Reg rs2)  { r(0x00, rs2, rs1, 0x2, rd); }
+    void sltu(Reg rd, Reg rs1, Reg rs2) { r(0x00, rs2, rs1, 0x3, rd); }
+    void mul(Reg rd, Reg rs1, Reg rs2)  { r(0x01, rs2, rs1, 0x0, rd); }
+
+    // I-type
+    void addi(Reg rd, Reg rs1, int32_t imm) { i(imm, rs1, 0x0, rd, 0x13); }
+    void xori(Reg rd, Reg rs1, int32_t imm) { i(imm, rs1, 0x4, rd, 0x13); }
+    void andi(Reg rd, Reg rs1, int32_t imm) { i(imm, rs1, 0x7, rd, 0x13); }
+    void slti(Reg rd, Reg rs1, int32_t imm) { i(imm, rs1, 0x2, rd, 0x13); }
+    void slli(Reg rd, Reg rs1, uint32_t sh) { i(sh & 0x1F, rs1, 0x1, rd, 0x13); }
+    void srli(Reg rd, Reg rs1, uint32_t sh) { i(sh & 0x1F, rs1, 0x5, rd, 0x13); }
+    void lh(Reg rd, int32_t off, Reg rs1)   { i(off, rs1, 0x1, rd, 0x03); }
+    void lw(Reg rd, int32_t off, Reg rs1)   { i(off, rs1, 0x2, rd, 0x03); }
+    void jalr(Reg rd, int32_t off, Reg rs1) { i(off, rs1, 0x0, rd, 0x67); }
+    void ebreak() { emit(0x00100073); }
+
+    // S-type
+    void sw(Reg rs2, int32_t off, Reg rs1) {
+        uint32_t imm = uint32_t(off);
+        emit(((imm >> 5) & 0x7F) << 25 | rs2 << 20 | rs1 << 15 | 0x2 << 12 | (imm & 0x1F) << 7 | 0x23);
+    }
+
+    // U-type
+    void lui(Reg rd, uint32_t imm) { emit((imm & 0xFFFFF000) | rd << 7 | 0x37); }
+
+    // B-type / J-type по метке
+    void beq(Reg rs1, Reg rs2, const std::string& l)  { b(0x0, rs1, rs2, l); }
+    void bne(Reg rs1, Reg rs2, const std::string& l)  { b(0x1, rs1, rs2, l); }
+    void blt(Reg rs1, Reg rs2, const std::string& l)  { b(0x4, rs1, rs2, l); }
+    void bge(Reg rs1, Reg rs2, const std::string& l)  { b(0x5, rs1, rs2, l); }
+    void bltu(Reg rs1, Reg rs2, const std::string& l) { b(0x6, rs1, rs2, l); }
+    void j(const std::string& l) {
+        fixups_.push_back({uint32_t(code_.size()), l, true});
+        emit(0x6F);
+    }
+
+    // псевдоинструкции
+    void li(Reg rd, uint32_t value) {
+        uint32_t hi = (value + 0x800) & 0xFFFFF000;
+        int32_t lo = int32_t(value - hi);
+        if (hi) {
+            lui(rd, hi);
+            if (lo) addi(rd, rd, lo);
+        } else {
+            addi(rd, zero, lo);
+        }
+    }
+    void mv(Reg rd, Reg rs) { addi(rd, rs, 0); }
+    void beqz(Reg rs, const std::string& l) { beq(rs, zero, l); }
+    void bnez(Reg rs, const std::string& l) { bne(rs, zero, l); }
+
+    void label(const std::string& l) { labels_[l] = uint32_t(code_.size()) * 4; }
+
+    std::vector<uint8_t> finish() {
+        for (const Fixup& f : fixups_) {
+            auto it = labels_.find(f.label);
+            if (it == labels_.end()) throw std::runtime_error("Undefined label: " + f.label);
+            uint32_t off = it->second - f.index * 4;
+            uint32_t& w = code_[f.index];
+            if (f.is_jal) {
+                w |= ((off >> 20) & 0x1) << 31 | ((off >> 1) & 0x3FF) << 21
+                   | ((off >> 11) & 0x1) << 20 | ((off >> 12) & 0xFF) << 12;
+            } else {
+                w |= ((off >> 12) & 0x1) << 31 | ((off >> 5) & 0x3F) << 25
+                   | ((off >> 1) & 0xF) << 8 | ((off >> 11) & 0x1) << 7;
+            }
+        }
+
+        std::vector<uint8_t> bytes(code_.size() * 4);
+        for (size_t k = 0; k < code_.size(); ++k)
+            for (int b = 0; b < 4; ++b)
+                bytes[k * 4 + b] = uint8_t(code_[k] >> (8 * b));
+        return bytes;
+    }
+
+private:
+    struct Fixup {
+        uint32_t index;
+        std::string label;
+        bool is_jal;
+    };
+
+    void emit(uint32_t w) { code_.push_back(w); }
+
+    void r(uint32_t f7, Reg rs2, Reg rs1, uint32_t f3, Reg rd) {
+        emit(f7 << 25 | rs2 << 20 | rs1 << 15 | f3 << 12 | rd << 7 | 0x33);
+    }
+
+    void i(int32_t imm, Reg rs1, uint32_t f3, Reg rd, uint32_t op) {
+        emit((uint32_t(imm) & 0xFFF) << 20 | rs1 << 15 | f3 << 12 | rd << 7 | op);
+    }
+
+    void b(uint32_t f3, Reg rs1, Reg rs2, const std::string& l) {
+        fixups_.push_back({uint32_t(code_.size()), l, false});
+        emit(rs2 << 20 | rs1 << 15 | f3 << 12 | 0x63);
+    }
+
+private:
+    std::vector<uint32_t> code_;
+    std::map<std::string, uint32_t> labels_;
+    std::vector<Fixup> fixups_;
+};
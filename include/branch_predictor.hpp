@@ -0,0 +1,100 @@
+#pragma once // branch_predictor.hpp
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct BranchStats {
+    uint64_t cond_branches = 0;
+    uint64_t cond_mispredicts = 0;   // неверное направление
+    uint64_t jumps = 0;              // jal / jalr
+    uint64_t target_mispredicts = 0; // нет цели в BTB/RAS или цель неверная
+    uint64_t btb_lookups = 0;
+    uint64_t btb_hits = 0;
+    uint64_t returns = 0;
+    uint64_t ras_hits = 0;
+
+    uint64_t mispredicts() const { return cond_mispredicts + target_mispredicts; }
+};
+
+// Предсказатель направления условных переходов. predict() возвращает
+// предсказание, сделанное до исхода, и сразу обучается на taken -
+// один виртуальный вызов на переход.
+class DirectionPredictor {
+public:
+    virtual ~DirectionPredictor() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool predict(uint32_t pc, uint32_t target, bool taken) = 0;
+};
+
+// backward taken, forward not taken
+class StaticPredictor : public DirectionPredictor {
+public:
+    const char* name() const override { return "static"; }
+    bool predict(uint32_t pc, uint32_t target, bool) override { return target <= pc; }
+};
+
+// 2-битные счётчики по pc
+class BimodalPredictor : public DirectionPredictor {
+public:
+    explicit BimodalPredictor(uint32_t table_bits);
+
+    const char* name() const override { return "bimodal"; }
+    bool predict(uint32_t pc, uint32_t target, bool taken) override;
+
+private:
+    std::vector<uint8_t> counters_;
+    uint32_t mask_;
+};
+
+// 2-битные счётчики по pc xor глобальная история
+class GsharePredictor : public DirectionPredictor {
+public:
+    explicit GsharePredictor(uint32_t table_bits);
+
+    const char* name() const override { return "gshare"; }
+    bool predict(uint32_t pc, uint32_t target, bool taken) override;
+
+private:
+    std::vector<uint8_t> counters_;
+    uint32_t mask_;
+    uint32_t history_ = 0;
+};
+
+std::unique_ptr<DirectionPredictor> make_direction_predictor(const std::string& name);
+
+// Модель front-end: направление + BTB (прямого отображения) + стек возвратов.
+// Processor сообщает о каждом исполненном переходе.
+class BranchUnit {
+public:
+    BranchUnit(std::unique_ptr<DirectionPredictor> direction, uint32_t btb_entries, uint32_t ras_depth);
+
+    void on_branch(uint32_t pc, uint32_t target, bool taken);
+    void on_jal(uint32_t pc, uint32_t target, uint8_t rd);
+    void on_jalr(uint32_t pc, uint32_t target, uint8_t rd, uint8_t rs1);
+
+    const char* name() const { return direction_->name(); }
+    const BranchStats& stats() const { return stats_; }
+
+private:
+    bool btb_predict(uint32_t pc, uint32_t target);
+    void push_return(uint32_t addr);
+
+private:
+    struct BtbEntry {
+        uint32_t pc = 0;
+        uint32_t target = 0;
+        bool valid = false;
+    };
+
+private:
+    std::unique_ptr<DirectionPredictor> direction_;
+    std::vector<BtbEntry> btb_;
+    uint32_t btb_mask_;
+    std::vector<uint32_t> ras_;
+    uint32_t ras_top_ = 0;   // циклический буфер, переполнение затирает старые
+    uint32_t ras_count_ = 0;
+    BranchStats stats_;
+};
@@ -1,23 +1,42 @@
 #pragma once // cache_abstract.hpp
 
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 
 #include "ram.hpp"
 #include "config.hpp"
+#include "mshr.hpp"
+#include "victim_cache.hpp"
 
 struct CacheStats {
     uint64_t instr_access = 0;
     uint64_t instr_hit = 0;
     uint64_t data_access = 0;
     uint64_t data_hit = 0;
+    uint64_t evictions = 0;  // вытеснения валидных строк
+    uint64_t writebacks = 0; // записи dirty строк в RAM (при вытеснении и flush)
+    uint64_t misaligned_access = 0; // адрес не кратен размеру
+    uint64_t split_access = 0;      // обращение через границу строки (2 поиска)
 };
 
-enum class AccessType {
+enum class AccessType : uint8_t {
     Instruction,
     Data
 };
 
+struct AccessEvent {
+    uint32_t addr;
+    uint8_t size;
+    AccessType type;
+    bool is_write;
+    bool hit;
+};
+
+// Приёмник пачек событий доступа, ctx передаётся без изменений
+using AccessSink = void (*)(void* ctx, const AccessEvent* events, size_t count);
+
 class CacheAbstract {
 public:
     explicit CacheAbstract(RAM& ram);
@@ -30,9 +49,30 @@ public:
     void write16(uint32_t addr, uint16_t value);
     void write32(uint32_t addr, uint32_t value);
 
+    // Невыровненное обращение, разрезанное MMU на границе страницы: хвост
+    // лежит с начала другой физической страницы next. Считается как
+    // обычное split обращение
+    uint32_t read_across(uint32_t addr, uint32_t next, uint32_t size, AccessType access_type);
+    void write_across(uint32_t addr, uint32_t next, uint32_t value, uint32_t size);
+
     void flush(); // all changed data write back to ram
+
+    // Копирует dirty строки в RAM, не снимая dirty и не трогая статистику:
+    // для просмотра памяти посреди прогона
+    void sync_to_ram();
     
-    CacheStats stats() const { return stats_; }
+    const CacheStats& stats() const { return stats_; }
+
+    // События копятся в буфере и отдаются пачками по ACCESS_EVENT_BATCH
+    void set_access_sink(AccessSink sink, void* ctx);
+    void drain_events(); // отдать неполную пачку
+
+    // Необязательные структуры на пути промаха, 0 записей - отключить
+    void attach_victim_cache(uint32_t entries);
+    void attach_mshr(uint32_t entries, uint32_t miss_latency = MEMORY_MISS_LATENCY);
+
+    const VictimCache* victim_cache() const { return victim_.get(); }
+    const MshrFile* mshr() const { return mshr_.get(); }
 
 protected:
     struct Line {
@@ -48,10 +88,25 @@ protected:
     virtual void on_fill(uint32_t set, uint32_t way) = 0;
 
     Line& fetch_line(uint32_t addr, AccessType access_type);
+    void write_back(uint32_t base, const uint8_t* data);
+
+    void record(uint32_t addr, uint8_t size, AccessType type, bool is_write);
+
+    uint32_t read_split(uint32_t addr, uint32_t next, uint32_t size, AccessType type);
+    void write_split(uint32_t addr, uint32_t next, uint32_t value, uint32_t size);
 
 protected:
     RAM& ram_;
     CacheStats stats_;
+    bool last_hit_ = false; // результат последнего fetch_line
+
+    AccessSink sink_ = nullptr;
+    void* sink_ctx_ = nullptr;
+    AccessEvent events_[ACCESS_EVENT_BATCH];
+    uint32_t event_count_ = 0;
+
+    std::unique_ptr<VictimCache> victim_;
+    std::unique_ptr<MshrFile> mshr_;
 
     Line cache_[CACHE_SET_COUNT][CACHE_WAY];
 };
@@ -1,16 +1,17 @@
 #pragma once // cache_bplru.hpp
 
 #include "cache_abstract.hpp"
+#include "replacement_policy.hpp"
 
 class CacheBpLRU : public CacheAbstract {
 public:
     explicit CacheBpLRU(RAM& ram);
 
 private:
-    uint32_t choose_victim(uint32_t set) override;
-    void on_hit(uint32_t set, uint32_t way) override;
-    void on_fill(uint32_t set, uint32_t way) override;
+    uint32_t choose_victim(uint32_t set) override { return policy_.choose_victim(set); }
+    void on_hit(uint32_t set, uint32_t way) override { policy_.on_hit(set, way); }
+    void on_fill(uint32_t set, uint32_t way) override { policy_.on_fill(set, way); }
 
 private:
-    bool used[CACHE_SET_COUNT][CACHE_WAY];
+    BpLruPolicy policy_;
 };
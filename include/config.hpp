@@ -14,3 +14,15 @@ constexpr uint32_t CACHE_SET_COUNT = 32;
 constexpr uint32_t CACHE_WAY = 4;
 constexpr uint32_t CACHE_LINE_COUNT = CACHE_SET_COUNT * CACHE_WAY;
 constexpr uint32_t CACHE_SIZE = CACHE_LINE_COUNT * CACHE_LINE_SIZE;
+
+constexpr uint32_t ACCESS_EVENT_BATCH = 256; // событий доступа в одной пачке для подписчика
+constexpr uint32_t MEMORY_MISS_LATENCY = 100; // тактов на промах в память в модели MSHR
+
+constexpr uint32_t BPRED_TABLE_BITS = 12; // 4096 счётчиков в таблицах предсказателя
+constexpr uint32_t BTB_ENTRIES = 512;
+constexpr uint32_t RAS_DEPTH = 16;
+
+constexpr uint32_t PAGE_OFFSET_LEN = 12; // Sv32: страницы 4 КБ
+constexpr uint32_t PAGE_SIZE = 1u << PAGE_OFFSET_LEN;
+constexpr uint32_t TLB_SETS = 8;         // по умолчанию 8 x 4 = 32 записи
+constexpr uint32_t TLB_WAYS = 4;
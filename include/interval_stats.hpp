@@ -0,0 +1,92 @@
+#pragma once // interval_stats.hpp
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "cache_abstract.hpp"
+
+enum class IntervalUnit {
+    Instructions,
+    Accesses
+};
+
+enum class IntervalFormat {
+    Csv,
+    Binary
+};
+
+// Приращения статистики кеша за один интервал
+struct IntervalSample {
+    uint64_t index = 0;        // номер интервала
+    uint64_t instructions = 0; // исполнено инструкций к концу интервала
+    uint64_t accesses = 0;     // обращений к кешу к концу интервала
+    uint64_t instr_access = 0;
+    uint64_t instr_hit = 0;
+    uint64_t data_access = 0;
+    uint64_t data_hit = 0;
+    uint64_t evictions = 0;
+    uint64_t writebacks = 0;
+};
+
+// Буферизованная запись снимков в файл, общий для всех политик.
+//
+// CSV: строка заголовка, затем policy,interval,instructions,accesses,...
+// Binary: "RVIS", u32 версия, затем записи (порядок байт хоста):
+//   1 u8 id, u8 len, имя политики   - объявление политики
+//   2 u8 id, 9 x u64 полей IntervalSample
+class IntervalWriter {
+public:
+    IntervalWriter(const std::string& filename, IntervalFormat format);
+    ~IntervalWriter();
+
+    IntervalWriter(const IntervalWriter&) = delete;
+    IntervalWriter& operator=(const IntervalWriter&) = delete;
+
+    uint8_t add_policy(const std::string& name);
+    void write(uint8_t policy, const IntervalSample& sample);
+    void flush();
+
+private:
+    void append(const void* data, size_t size);
+
+private:
+    std::FILE* file_;
+    IntervalFormat format_;
+    std::vector<std::string> policies_;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+};
+
+// Снимки каждые period инструкций или обращений. tick() вызывается
+// процессором после каждого шага, медленный путь - только на границе.
+class IntervalRecorder {
+public:
+    IntervalRecorder(IntervalWriter& writer, const std::string& policy,
+                     IntervalUnit unit, uint64_t period);
+
+    void tick(uint64_t retired, const CacheStats& s) {
+        uint64_t pos = unit_ == IntervalUnit::Instructions
+            ? retired
+            : s.instr_access + s.data_access;
+        if (pos >= next_mark_)
+            snapshot(retired, s);
+    }
+
+    // Последний неполный интервал (в т.ч. writebacks от flush)
+    void finish(uint64_t retired, const CacheStats& s);
+
+private:
+    void snapshot(uint64_t retired, const CacheStats& s);
+
+private:
+    IntervalWriter& writer_;
+    uint8_t policy_;
+    IntervalUnit unit_;
+    uint64_t period_;
+    uint64_t next_mark_;
+    uint64_t index_ = 0;
+    uint64_t last_instructions_ = 0;
+    CacheStats last_;
+};
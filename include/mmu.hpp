@@ -0,0 +1,109 @@
+#pragma once // mmu.hpp
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cache_abstract.hpp"
+#include "replacement_policy.hpp"
+
+enum class MmuAccess : uint8_t {
+    Fetch,
+    Load,
+    Store
+};
+
+struct TlbStats {
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t evictions = 0;
+    uint64_t flushes = 0; // sfence.vma
+};
+
+struct TlbConfig {
+    uint32_t sets = TLB_SETS;
+    uint32_t ways = TLB_WAYS;
+    std::string policy = "lru";
+};
+
+// Множественно-ассоциативный TLB, запись - одна страница 4 КБ
+// (мегастраницы Sv32 кладутся по 4 КБ кусками)
+class Tlb {
+public:
+    struct Entry {
+        uint32_t vpn = 0;
+        uint32_t ppn = 0;
+        uint8_t perms = 0; // биты R/W/X из PTE
+        bool dirty = false; // D уже выставлен в PTE
+        bool valid = false;
+    };
+
+public:
+    explicit Tlb(const TlbConfig& config);
+
+    Entry* lookup(uint32_t vpn);
+    Entry& insert(const Entry& entry);
+    void flush();
+
+    const char* policy_name() const { return policy_->name(); }
+    uint32_t entries() const { return uint32_t(entries_.size()); }
+    const TlbStats& stats() const { return stats_; }
+
+private:
+    std::vector<Entry> entries_;
+    std::unique_ptr<ReplacementPolicy> policy_;
+    uint32_t set_mask_;
+    uint32_t ways_;
+    TlbStats stats_;
+};
+
+struct PageWalkStats {
+    uint64_t walks = 0;
+    uint64_t pte_reads = 0;     // обращения к PTE через кеш данных
+    uint64_t pte_read_hits = 0;
+    uint64_t superpages = 0;    // обходы, закончившиеся на мегастранице
+    uint64_t ad_updates = 0;    // записи PTE для выставления A/D
+};
+
+// Sv32: двухуровневая таблица страниц с корнем по физическому адресу root.
+// PTE читаются и обновляются через тот же кеш, что и данные программы.
+// Ловушек в ядре нет, поэтому page fault - исключение. Уровней привилегий
+// тоже нет: биты U/G и ASID не проверяются.
+class Mmu {
+public:
+    Mmu(CacheAbstract& cache, uint32_t root, const TlbConfig& itlb, const TlbConfig& dtlb);
+
+    uint32_t translate(uint32_t vaddr, MmuAccess access) {
+        Tlb& tlb = access == MmuAccess::Fetch ? itlb_ : dtlb_;
+        uint32_t vpn = vaddr >> PAGE_OFFSET_LEN;
+
+        Tlb::Entry* e = tlb.lookup(vpn);
+        if (!e || !permitted(*e, access))
+            e = walk(tlb, vaddr, access);
+
+        return (e->ppn << PAGE_OFFSET_LEN) | (vaddr & (PAGE_SIZE - 1));
+    }
+
+    void flush_tlbs(); // sfence.vma
+
+    const Tlb& itlb() const { return itlb_; }
+    const Tlb& dtlb() const { return dtlb_; }
+    const PageWalkStats& walk_stats() const { return walk_stats_; }
+
+private:
+    // Права и D для store проверены; иначе нужен обход таблицы
+    static bool permitted(const Tlb::Entry& e, MmuAccess access);
+
+    Tlb::Entry* walk(Tlb& tlb, uint32_t vaddr, MmuAccess access);
+    uint32_t read_pte(uint32_t addr);
+
+    [[noreturn]] static void page_fault(uint32_t vaddr, MmuAccess access, const char* reason);
+
+private:
+    CacheAbstract& cache_;
+    uint32_t root_;
+    Tlb itlb_;
+    Tlb dtlb_;
+    PageWalkStats walk_stats_;
+};
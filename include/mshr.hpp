@@ -0,0 +1,37 @@
+#pragma once // mshr.hpp
+
+#include <cstdint>
+#include <vector>
+
+struct MshrStats {
+    uint64_t cycles = 0;       // модельное время: 1 такт на обращение + простои
+    uint64_t allocations = 0;  // первичные промахи, занявшие MSHR
+    uint64_t merges = 0;       // обращения к строке, чей промах ещё не завершён
+    uint64_t full_stalls = 0;  // промахи, ждавшие свободный MSHR
+    uint64_t stall_cycles = 0;
+};
+
+// Файл MSHR с простой моделью времени. Каждое обращение занимает такт и
+// не ждёт данных (неблокирующий кеш), промах в память держит MSHR
+// miss_latency тактов. Обращение к строке с незавершённым промахом
+// сливается с ним; если свободных MSHR нет, обращение ждёт ближайший.
+class MshrFile {
+public:
+    MshrFile(uint32_t entries, uint32_t miss_latency);
+
+    void access(uint32_t line_addr, bool memory_miss);
+
+    uint32_t size() const { return uint32_t(entries_.size()); }
+    const MshrStats& stats() const { return stats_; }
+
+private:
+    struct Entry {
+        uint32_t line_addr = 0;
+        uint64_t ready = 0; // такт, когда строка придёт из памяти
+    };
+
+private:
+    std::vector<Entry> entries_;
+    uint32_t miss_latency_;
+    MshrStats stats_;
+};
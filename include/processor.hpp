@@ -1,12 +1,15 @@
 #pragma once // processor.hpp
 
+#include <array>
 #include <cstdint>
-#include <functional>
+#include <span>
 #include <stdexcept>
-#include <vector>
 #include <string>
 
+#include "branch_predictor.hpp"
 #include "cache_abstract.hpp"
+#include "interval_stats.hpp"
+#include "mmu.hpp"
 
 struct Command {
     uint32_t raw = 0;
@@ -20,19 +23,55 @@ struct Command {
     int32_t imm = 0;
 };
 
+// Пары инструкций, которые исполняются одним слитым обработчиком
+enum class FusedIdiom : uint8_t {
+    None,
+    LuiAddi,    // lui rd, hi; addi rd2, rd, lo   - загрузка 32-битной константы
+    AuipcJalr,  // auipc rd, hi; jalr rd2, lo(rd) - дальний вызов/переход
+    CmpBranch,  // slt/sltu/slti/sltiu rd; beq/bne rd, x0 - сравнение + ветвление
+    SlliAdd,    // slli rd, rs, sh; add rd2, rd, rs2 - адресная арифметика
+    Count
+};
+
+struct FusionStats {
+    uint64_t lui_addi = 0;
+    uint64_t auipc_jalr = 0;
+    uint64_t cmp_branch = 0;
+    uint64_t slli_add = 0;
+};
+
 class Processor {
 public:
-    explicit Processor(CacheAbstract& cache, const std::vector<uint32_t>& regs);
+    explicit Processor(CacheAbstract& cache, std::span<const uint32_t> regs);
     
     void run();
 
+    // Одна инструкция или слитая пара; возвращает число исполненных инструкций.
+    // allow_fusion = false гарантирует ровно одну инструкцию.
+    uint32_t step(bool allow_fusion = true);
+    bool halted() const { return halted_; }
+
     uint32_t get_reg(int i) const;
+    std::span<const uint32_t, 32> regs() const { return regs_; }
+    uint32_t pc() const { return pc_; }
+
+    void set_fusion_enabled(bool enabled) { fusion_enabled_ = enabled; }
+    FusionStats fusion_stats() const { return fusion_stats_; }
+    uint64_t retired() const { return retired_; } // исполненные инструкции (слитая пара = 2)
+
+    void set_interval_recorder(IntervalRecorder* recorder) { interval_ = recorder; }
+    void set_branch_unit(BranchUnit* unit) { branch_ = unit; }
+
+    // С MMU pc и адреса load/store виртуальные (Sv32)
+    void set_mmu(Mmu* mmu) { mmu_ = mmu; }
 
 private:
     Command parse(uint32_t raw_instr);
-    std::function<void(Command&, Processor&)> get_function(const Command& cmd);
+    using Handler = void (Processor::*)(Command&);
+    Handler get_function(const Command& cmd);
 
     void exec_r_type(Command& c);
+    void exec_mul_div(Command& c);
     void exec_load(Command& c);
     void exec_imm_arith(Command& c);
     void exec_store(Command& c);
@@ -45,6 +84,24 @@ private:
 
     void validate_opcode(const Command& c);
 
+    static bool is_fusion_head(const Command& head);
+    static FusedIdiom match_fusion(const Command& head, const Command& tail);
+    void exec_fused(FusedIdiom idiom, Command& head, Command& tail);
+
+    uint32_t fetch(uint32_t pc) {
+        return cache_.read32(mmu_ ? mmu_->translate(pc, MmuAccess::Fetch) : pc, AccessType::Instruction);
+    }
+
+    // Части такого обращения лежат на разных физических страницах:
+    // каждая страница транслируется один раз, в кеш идут две части
+    bool crosses_page(uint32_t addr, uint32_t size) const {
+        return mmu_ && (addr & (PAGE_SIZE - 1)) + size > PAGE_SIZE;
+    }
+
+    static uint32_t next_page(uint32_t addr) {
+        return (addr & ~(PAGE_SIZE - 1)) + PAGE_SIZE;
+    }
+
     uint32_t read_mem(uint32_t addr, uint32_t size, bool is_signed);
     void write_mem(uint32_t addr, uint32_t value, uint32_t size);
 
@@ -52,8 +109,19 @@ private:
 
 private:
     CacheAbstract& cache_;
-    std::vector<uint32_t> regs_;
+    std::array<uint32_t, 32> regs_;
     uint32_t pc_;
     uint32_t start_ra_;
+    bool halted_ = false;
+
+    Command pending_;
+    bool has_pending_ = false; // следующая инструкция уже выбрана при поиске пары
+
+    bool fusion_enabled_ = false; // на ядрах riscv-bench выигрыша нет, включается явно
+    FusionStats fusion_stats_;
+    uint64_t retired_ = 0;
 
+    IntervalRecorder* interval_ = nullptr;
+    BranchUnit* branch_ = nullptr;
+    Mmu* mmu_ = nullptr;
 };
@@ -1,16 +1,24 @@
 #pragma once // ram.hpp
 
 #include <cstdint>
+#include <span>
 
 class RAM {
 public:
     explicit RAM(uint32_t size);
     ~RAM();
 
+    // владеет буфером, на RAM ссылаются кеши - не копируется и не перемещается
+    RAM(const RAM&) = delete;
+    RAM& operator=(const RAM&) = delete;
+    RAM(RAM&&) = delete;
+    RAM& operator=(RAM&&) = delete;
+
     uint8_t read8(uint32_t address) const;
     void write8(uint32_t address, uint8_t value);
 
     uint32_t size() const noexcept { return size_; }
+    std::span<const uint8_t> bytes() const noexcept { return {data_, size_}; }
 
 private:
     uint32_t size_;
@@ -0,0 +1,57 @@
+#pragma once // replacement_policy.hpp
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Политика замещения для произвольной геометрии sets x ways.
+// Используется кешами (CacheLRU, CacheBpLRU) и TLB.
+class ReplacementPolicy {
+public:
+    ReplacementPolicy(uint32_t sets, uint32_t ways);
+    virtual ~ReplacementPolicy() = default;
+
+    virtual const char* name() const = 0;
+    virtual uint32_t choose_victim(uint32_t set) = 0;
+    virtual void on_hit(uint32_t set, uint32_t way) = 0;
+    virtual void on_fill(uint32_t set, uint32_t way) = 0;
+
+    uint32_t sets() const { return sets_; }
+    uint32_t ways() const { return ways_; }
+
+protected:
+    uint32_t sets_;
+    uint32_t ways_;
+};
+
+// Точный LRU: у каждой линии ранг 0 (свежая) .. ways-1 (кандидат на вытеснение)
+class LruPolicy final : public ReplacementPolicy {
+public:
+    LruPolicy(uint32_t sets, uint32_t ways);
+
+    const char* name() const override { return "LRU"; }
+    uint32_t choose_victim(uint32_t set) override;
+    void on_hit(uint32_t set, uint32_t way) override;
+    void on_fill(uint32_t set, uint32_t way) override;
+
+private:
+    std::vector<uint8_t> last_used_;
+};
+
+// Bit-pLRU: бит использования на линию, сброс когда все биты выставлены
+class BpLruPolicy final : public ReplacementPolicy {
+public:
+    BpLruPolicy(uint32_t sets, uint32_t ways);
+
+    const char* name() const override { return "bpLRU"; }
+    uint32_t choose_victim(uint32_t set) override;
+    void on_hit(uint32_t set, uint32_t way) override;
+    void on_fill(uint32_t set, uint32_t way) override;
+
+private:
+    std::vector<uint8_t> used_;
+};
+
+// "lru" или "bplru"
+std::unique_ptr<ReplacementPolicy> make_replacement_policy(const std::string& name, uint32_t sets, uint32_t ways);
@@ -0,0 +1,77 @@
+#pragma once // result_writer.hpp
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class ResultFormat {
+    Ndjson,
+    Columnar
+};
+
+// Строки результатов (конфигурация, статистика, время) для прогонов-свипов.
+// Всё копится в памяти и дописывается в конец файла одним write(), поэтому
+// много запусков с одним файлом дают один набор данных.
+//
+// Схема задаётся первой строкой: следующие должны содержать те же поля
+// в том же порядке.
+//
+// NDJSON: объект на строку.
+// Columnar: "RVRC", u32 версия (только в начале файла), затем блоки строк:
+//   u32 размер блока без этого поля, u32 строк, u16 колонок, для каждой колонки:
+//   u8 длина имени, имя, u8 тип, u32 размер данных, данные
+//   тип 0 - u64: zigzag дельты от предыдущей строки в LEB128
+//   тип 1 - f64: значения подряд
+//   тип 2 - строка: varint размер словаря, строки (varint длина + байты),
+//           затем varint индексы по строкам
+class ResultWriter {
+public:
+    ResultWriter(std::string filename, ResultFormat format);
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    void begin_row();
+    void field(std::string_view name, uint64_t value);
+    void field(std::string_view name, double value);
+    void field(std::string_view name, std::string_view value);
+    void end_row();
+
+    uint32_t rows() const { return rows_; }
+
+    // Дописывает накопленное в файл и очищает буферы
+    void write();
+
+private:
+    enum class ColumnType : uint8_t {
+        U64,
+        F64,
+        String
+    };
+
+    struct Column {
+        std::string name;
+        ColumnType type;
+        std::vector<uint64_t> u64;
+        std::vector<double> f64;
+        std::vector<uint32_t> ids;        // индексы в dict
+        std::vector<std::string> dict;
+    };
+
+private:
+    Column& next_column(std::string_view name, ColumnType type);
+    void json_key(std::string_view name);
+
+    std::vector<char> encode_block() const;
+
+private:
+    std::string filename_;
+    ResultFormat format_;
+    std::vector<Column> columns_;
+    bool schema_fixed_ = false; // после первой строки набор колонок не меняется
+    bool in_row_ = false;
+    size_t column_ = 0;         // номер следующего поля в текущей строке
+    uint32_t rows_ = 0;
+    std::string json_;
+};
@@ -0,0 +1,135 @@
+#pragma once // self_profile.hpp
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Профилирование самого эмулятора на хосте (--self-profile)
+
+enum class HostEvent : uint8_t {
+    Cycles,
+    Instructions,
+    L1dMisses,
+    LlcMisses,
+    BranchMisses,
+    Count
+};
+
+constexpr size_t HOST_EVENT_COUNT = size_t(HostEvent::Count);
+
+struct HostCounters {
+    std::array<uint64_t, HOST_EVENT_COUNT> values = {};
+    std::array<bool, HOST_EVENT_COUNT> valid = {};
+    uint64_t timestamp_ticks = 0; // rdtsc (или нс steady_clock) за тот же отрезок
+    double seconds = 0;
+
+    uint64_t operator[](HostEvent e) const { return values[size_t(e)]; }
+    bool has(HostEvent e) const { return valid[size_t(e)]; }
+};
+
+// Метка времени для замеров, в которых системный вызов слишком дорог
+inline uint64_t host_timestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Группа счётчиков perf_event_open (только user-space). Если perf
+// недоступен (нет PMU, perf_event_paranoid, не Linux), остаётся только
+// host_timestamp(), и в cycles попадают его тики.
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return leader_ >= 0; }
+
+    void start();
+    HostCounters stop();
+
+private:
+    int leader_ = -1;
+    std::array<int, HOST_EVENT_COUNT> fds_;
+    std::array<int, HOST_EVENT_COUNT> slot_; // позиция события в групповом чтении, -1 - не открыто
+    uint32_t opened_ = 0;
+    uint64_t start_ticks_ = 0;
+    std::chrono::steady_clock::time_point start_time_;
+};
+
+// Области, размечаемые пробами внутри ядра. Время включающее:
+// Execute содержит FetchLine для load/store, Decode - для выборки.
+enum class ProfileRegion : uint8_t {
+    Decode,    // выборка, parse, validate_opcode
+    Execute,   // обработчик инструкции или слитой пары с выборкой хвоста
+    FetchLine, // CacheAbstract::fetch_line
+    Count
+};
+
+constexpr size_t PROFILE_REGION_COUNT = size_t(ProfileRegion::Count);
+
+struct RegionStats {
+    uint64_t calls = 0;
+    uint64_t ticks = 0;
+};
+
+using ProfileRegions = std::array<RegionStats, PROFILE_REGION_COUNT>;
+
+const char* profile_region_name(ProfileRegion region);
+
+#ifdef RISCV_SELF_PROFILE
+
+// Накопители проб; процесс однопоточный, эмуляторы запускаются по очереди
+inline ProfileRegions g_profile_regions = {};
+
+class ProfileProbe {
+public:
+    explicit ProfileProbe(ProfileRegion region)
+        : stats_(g_profile_regions[size_t(region)])
+        , start_(host_timestamp())
+    {}
+
+    ~ProfileProbe() {
+        stats_.ticks += host_timestamp() - start_;
+        stats_.calls++;
+    }
+
+    ProfileProbe(const ProfileProbe&) = delete;
+    ProfileProbe& operator=(const ProfileProbe&) = delete;
+
+private:
+    RegionStats& stats_;
+    uint64_t start_;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(region) ProfileProbe PROFILE_CONCAT(profile_probe_, __LINE__)(ProfileRegion::region)
+
+constexpr bool SELF_PROFILE_PROBES = true;
+
+// Забирает накопленное и обнуляет накопители
+inline ProfileRegions take_profile_regions() {
+    ProfileRegions r = g_profile_regions;
+    g_profile_regions = {};
+    return r;
+}
+
+#else
+
+#define PROFILE_SCOPE(region) static_cast<void>(0)
+
+constexpr bool SELF_PROFILE_PROBES = false;
+
+inline ProfileRegions take_profile_regions() { return {}; }
+
+#endif
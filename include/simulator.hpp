@@ -0,0 +1,85 @@
+#pragma once // simulator.hpp
+
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include "cache_abstract.hpp"
+#include "processor.hpp"
+#include "ram.hpp"
+
+enum class CachePolicy {
+    LRU,
+    BpLRU
+};
+
+struct MemorySegment {
+    uint32_t addr;
+    std::span<const uint8_t> data;
+};
+
+// Встраиваемый симулятор: RAM + кеш + процессор за одним объектом.
+// Всё выделяется в конструкторе, step()/run_until() в памяти не выделяют.
+// Кеш и процессор ссылаются на соседние члены, поэтому объект не копируется
+// и не перемещается; если его нужно передавать, держите std::unique_ptr<Simulator>.
+class Simulator {
+public:
+    Simulator(std::span<const uint32_t> regs,
+              std::span<const MemorySegment> image,
+              CachePolicy policy = CachePolicy::LRU);
+
+    Simulator(const Simulator&) = delete;
+    Simulator& operator=(const Simulator&) = delete;
+
+    // До n инструкций или до остановки программы, возвращает сколько исполнено
+    uint64_t step(uint64_t n);
+
+    // Шаги по одной инструкции, пока pred(*this) не вернёт true
+    template <typename Pred>
+    uint64_t run_until(Pred&& pred, uint64_t max_instructions = UINT64_MAX) {
+        uint64_t executed = 0;
+        while (executed < max_instructions && !cpu_.halted() && !pred(*this))
+            executed += cpu_.step(false);
+        cache_->drain_events();
+        return executed;
+    }
+
+    // Подписка на пачки событий доступа к кешу
+    void subscribe(AccessSink sink, void* ctx) { cache_->set_access_sink(sink, ctx); }
+
+    // Sink - объект с operator()(std::span<const AccessEvent>)
+    template <typename Sink>
+    void subscribe(Sink& sink) {
+        cache_->set_access_sink(
+            [](void* ctx, const AccessEvent* events, size_t count) {
+                (*static_cast<Sink*>(ctx))(std::span<const AccessEvent>(events, count));
+            },
+            &sink);
+    }
+
+    void unsubscribe() { cache_->set_access_sink(nullptr, nullptr); }
+
+    bool halted() const { return cpu_.halted(); }
+    uint32_t pc() const { return cpu_.pc(); }
+    std::span<const uint32_t, 32> regs() const { return cpu_.regs(); }
+    uint64_t retired() const { return cpu_.retired(); }
+    const CacheStats& stats() const { return cache_->stats(); }
+    FusionStats fusion_stats() const { return cpu_.fusion_stats(); }
+
+    // Sv32 с корнем таблицы страниц root; pc и адреса становятся виртуальными
+    void enable_mmu(uint32_t root, const TlbConfig& itlb = {}, const TlbConfig& dtlb = {});
+    const Mmu* mmu() const { return mmu_.get(); }
+
+    // Копирует dirty строки в RAM и отдаёт её содержимое без копирования.
+    // Статистика кеша (writebacks) и dirty биты не меняются
+    std::span<const uint8_t> memory();
+
+    Processor& processor() { return cpu_; }
+    CacheAbstract& cache() { return *cache_; }
+
+private:
+    RAM ram_;
+    std::unique_ptr<CacheAbstract> cache_;
+    Processor cpu_;
+    std::unique_ptr<Mmu> mmu_;
+};
@@ -0,0 +1,65 @@
+#pragma once // victim_cache.hpp
+
+#include <cstdint>
+#include <vector>
+
+#include "config.hpp"
+
+struct VictimStats {
+    uint64_t lookups = 0;    // промахи основного кеша, проверенные в victim cache
+    uint64_t hits = 0;
+    uint64_t inserts = 0;    // строки, вытесненные из основного кеша
+    uint64_t writebacks = 0; // dirty строки, вытесненные из victim cache в RAM
+};
+
+// Маленький полностью ассоциативный буфер строк, вытесненных из
+// основного кеша. Замещение LRU по счётчику обращений.
+class VictimCache {
+public:
+    explicit VictimCache(uint32_t entries);
+
+    // При попадании строка переносится в data и слот освобождается
+    bool take(uint32_t line_addr, uint8_t* data, bool& dirty);
+
+    // Кладёт строку; если пришлось вытеснить dirty строку, возвращает true
+    // и заполняет spill_addr/spill_data для записи в RAM
+    bool insert(uint32_t line_addr, const uint8_t* data, bool dirty,
+                uint32_t& spill_addr, uint8_t* spill_data);
+
+    // Вызывает write_back(addr, data) для всех dirty строк и помечает их чистыми
+    template <typename WriteBack>
+    void flush(WriteBack&& write_back) {
+        for (Entry& e : entries_) {
+            if (!e.valid || !e.dirty) continue;
+            write_back(e.line_addr, e.data);
+            e.dirty = false;
+            stats_.writebacks++;
+        }
+    }
+
+    // Как flush, но без изменения dirty и статистики
+    template <typename WriteBack>
+    void for_each_dirty(WriteBack&& write_back) const {
+        for (const Entry& e : entries_) {
+            if (e.valid && e.dirty)
+                write_back(e.line_addr, e.data);
+        }
+    }
+
+    uint32_t size() const { return uint32_t(entries_.size()); }
+    const VictimStats& stats() const { return stats_; }
+
+private:
+    struct Entry {
+        uint8_t data[CACHE_LINE_SIZE];
+        uint32_t line_addr = 0;
+        uint64_t last_use = 0;
+        bool valid = false;
+        bool dirty = false;
+    };
+
+private:
+    std::vector<Entry> entries_;
+    uint64_t clock_ = 0;
+    VictimStats stats_;
+};
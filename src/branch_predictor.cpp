@@ -0,0 +1,132 @@
+#include "branch_predictor.hpp"
+
+#include <stdexcept>
+
+#include "config.hpp"
+
+// Без условных переходов: исход гостевого перехода для хоста случаен
+// там, где плохо предсказуем и сам гостевой переход
+static inline void counter_update(uint8_t& c, bool taken) {
+    c += taken & (c < 3);
+    c -= !taken & (c > 0);
+}
+
+static inline bool is_link(uint8_t reg) {
+    return reg == 1 || reg == 5; // ra, t0 - соглашение RISC-V для вызовов
+}
+
+// BimodalPredictor
+
+BimodalPredictor::BimodalPredictor(uint32_t table_bits)
+    : counters_(1u << table_bits, 1)
+    , mask_((1u << table_bits) - 1)
+{}
+
+bool BimodalPredictor::predict(uint32_t pc, uint32_t, bool taken) {
+    uint8_t& c = counters_[(pc >> 2) & mask_];
+    bool predicted = c >= 2;
+    counter_update(c, taken);
+    return predicted;
+}
+
+// GsharePredictor
+
+GsharePredictor::GsharePredictor(uint32_t table_bits)
+    : counters_(1u << table_bits, 1)
+    , mask_((1u << table_bits) - 1)
+{}
+
+bool GsharePredictor::predict(uint32_t pc, uint32_t, bool taken) {
+    uint8_t& c = counters_[((pc >> 2) ^ history_) & mask_];
+    bool predicted = c >= 2;
+    counter_update(c, taken);
+    history_ = ((history_ << 1) | taken) & mask_;
+    return predicted;
+}
+
+std::unique_ptr<DirectionPredictor> make_direction_predictor(const std::string& name) {
+    if (name == "static") return std::make_unique<StaticPredictor>();
+    if (name == "bimodal") return std::make_unique<BimodalPredictor>(BPRED_TABLE_BITS);
+    if (name == "gshare") return std::make_unique<GsharePredictor>(BPRED_TABLE_BITS);
+    throw std::runtime_error("Unknown branch predictor: " + name);
+}
+
+// BranchUnit
+
+BranchUnit::BranchUnit(std::unique_ptr<DirectionPredictor> direction, uint32_t btb_entries, uint32_t ras_depth)
+    : direction_(std::move(direction))
+    , btb_(btb_entries)
+    , btb_mask_(btb_entries - 1)
+    , ras_(ras_depth)
+{
+    if (btb_entries == 0 || (btb_entries & (btb_entries - 1)))
+        throw std::runtime_error("BTB size must be a power of two");
+    if (ras_depth == 0)
+        throw std::runtime_error("RAS depth must be positive");
+}
+
+void BranchUnit::on_branch(uint32_t pc, uint32_t target, bool taken) {
+    stats_.cond_branches++;
+
+    bool wrong = direction_->predict(pc, target, taken) != taken;
+    stats_.cond_mispredicts += wrong;
+
+    // при неверном направлении ошибка уже посчитана, BTB только обучается
+    if (taken) {
+        bool hit = btb_predict(pc, target);
+        stats_.target_mispredicts += !wrong & !hit;
+    }
+}
+
+void BranchUnit::on_jal(uint32_t pc, uint32_t target, uint8_t rd) {
+    stats_.jumps++;
+
+    if (!btb_predict(pc, target))
+        stats_.target_mispredicts++;
+
+    if (is_link(rd))
+        push_return(pc + 4);
+}
+
+void BranchUnit::on_jalr(uint32_t pc, uint32_t target, uint8_t rd, uint8_t rs1) {
+    stats_.jumps++;
+
+    if (!is_link(rd) && is_link(rs1)) { // возврат
+        stats_.returns++;
+
+        bool hit = false;
+        if (ras_count_) {
+            ras_top_ = (ras_top_ + ras_.size() - 1) % ras_.size();
+            ras_count_--;
+            hit = ras_[ras_top_] == target;
+        }
+
+        if (hit) stats_.ras_hits++;
+        else stats_.target_mispredicts++;
+        return;
+    }
+
+    if (!btb_predict(pc, target))
+        stats_.target_mispredicts++;
+
+    if (is_link(rd))
+        push_return(pc + 4);
+}
+
+bool BranchUnit::btb_predict(uint32_t pc, uint32_t target) {
+    stats_.btb_lookups++;
+
+    BtbEntry& e = btb_[(pc >> 2) & btb_mask_];
+    bool hit = e.valid && e.pc == pc;
+    if (hit) stats_.btb_hits++;
+
+    bool correct = hit && e.target == target;
+    e = {pc, target, true};
+    return correct;
+}
+
+void BranchUnit::push_return(uint32_t addr) {
+    ras_[ras_top_] = addr;
+    ras_top_ = (ras_top_ + 1) % ras_.size();
+    if (ras_count_ < ras_.size()) ras_count_++;
+}
@@ -1,5 +1,7 @@
 #include "cache_abstract.hpp"
 
+#include "self_profile.hpp"
+
 static inline uint32_t addr_offset(uint32_t a) {
     return a & ((1u << CACHE_OFFSET_LEN) - 1);
 }
@@ -16,6 +18,10 @@ static inline uint32_t line_base(uint32_t a) {
     return a & ~(CACHE_LINE_SIZE - 1);
 }
 
+static inline uint32_t line_addr(uint32_t tag, uint32_t set) {
+    return (tag << (CACHE_INDEX_LEN + CACHE_OFFSET_LEN)) | (set << CACHE_OFFSET_LEN);
+}
+
 // ctor
 
 CacheAbstract::CacheAbstract(RAM& ram)
@@ -26,6 +32,27 @@ CacheAbstract::CacheAbstract(RAM& ram)
 
 // Public API
 
+void CacheAbstract::attach_victim_cache(uint32_t entries) {
+    flush();
+    victim_ = entries ? std::make_unique<VictimCache>(entries) : nullptr;
+}
+
+void CacheAbstract::attach_mshr(uint32_t entries, uint32_t miss_latency) {
+    mshr_ = entries ? std::make_unique<MshrFile>(entries, miss_latency) : nullptr;
+}
+
+void CacheAbstract::set_access_sink(AccessSink sink, void* ctx) {
+    drain_events();
+    sink_ = sink;
+    sink_ctx_ = ctx;
+}
+
+void CacheAbstract::drain_events() {
+    if (sink_ && event_count_)
+        sink_(sink_ctx_, events_, event_count_);
+    event_count_ = 0;
+}
+
 uint8_t CacheAbstract::read8(uint32_t addr, AccessType type) {
     if (type == AccessType::Instruction)
         stats_.instr_access++;
@@ -33,6 +60,7 @@ uint8_t CacheAbstract::read8(uint32_t addr, AccessType type) {
         stats_.data_access++;
 
     Line& line = fetch_line(addr, type);
+    if (sink_) record(addr, 1, type, false);
     return line.data[addr_offset(addr)];
 }
 
@@ -42,7 +70,12 @@ uint16_t CacheAbstract::read16(uint32_t addr, AccessType type) {
     else
         stats_.data_access++;
 
+    stats_.misaligned_access += (addr & (sizeof(uint16_t) - 1)) != 0;
+    if (addr_offset(addr) > CACHE_LINE_SIZE - sizeof(uint16_t)) [[unlikely]]
+        return uint16_t(read_split(addr, line_base(addr) + CACHE_LINE_SIZE, sizeof(uint16_t), type));
+
     Line& line = fetch_line(addr, type);
+    if (sink_) record(addr, 2, type, false);
     uint16_t value;
     std::memcpy(&value, &line.data[addr_offset(addr)], sizeof(uint16_t));
     return value;
@@ -54,7 +87,12 @@ uint32_t CacheAbstract::read32(uint32_t addr, AccessType type) {
     else
         stats_.data_access++;
 
+    stats_.misaligned_access += (addr & (sizeof(uint32_t) - 1)) != 0;
+    if (addr_offset(addr) > CACHE_LINE_SIZE - sizeof(uint32_t)) [[unlikely]]
+        return read_split(addr, line_base(addr) + CACHE_LINE_SIZE, sizeof(uint32_t), type);
+
     Line& line = fetch_line(addr, type);
+    if (sink_) record(addr, 4, type, false);
     uint32_t value;
     std::memcpy(&value, &line.data[addr_offset(addr)], sizeof(uint32_t));
     return value;
@@ -64,6 +102,7 @@ void CacheAbstract::write8(uint32_t addr, uint8_t value) {
     stats_.data_access++;
 
     Line& line = fetch_line(addr, AccessType::Data);
+    if (sink_) record(addr, 1, AccessType::Data, true);
     line.data[addr_offset(addr)] = value;
     line.dirty = true;
 }
@@ -71,7 +110,14 @@ void CacheAbstract::write8(uint32_t addr, uint8_t value) {
 void CacheAbstract::write16(uint32_t addr, uint16_t value) {
     stats_.data_access++;
 
+    stats_.misaligned_access += (addr & (sizeof(uint16_t) - 1)) != 0;
+    if (addr_offset(addr) > CACHE_LINE_SIZE - sizeof(uint16_t)) [[unlikely]] {
+        write_split(addr, line_base(addr) + CACHE_LINE_SIZE, value, sizeof(uint16_t));
+        return;
+    }
+
     Line& line = fetch_line(addr, AccessType::Data);
+    if (sink_) record(addr, 2, AccessType::Data, true);
     std::memcpy(&line.data[addr_offset(addr)], &value, sizeof(uint16_t));
     line.dirty = true;
 }
@@ -79,14 +125,93 @@ void CacheAbstract::write16(uint32_t addr, uint16_t value) {
 void CacheAbstract::write32(uint32_t addr, uint32_t value) {
     stats_.data_access++;
 
+    stats_.misaligned_access += (addr & (sizeof(uint32_t) - 1)) != 0;
+    if (addr_offset(addr) > CACHE_LINE_SIZE - sizeof(uint32_t)) [[unlikely]] {
+        write_split(addr, line_base(addr) + CACHE_LINE_SIZE, value, sizeof(uint32_t));
+        return;
+    }
+
     Line& line = fetch_line(addr, AccessType::Data);
+    if (sink_) record(addr, 4, AccessType::Data, true);
     std::memcpy(&line.data[addr_offset(addr)], &value, sizeof(uint32_t));
     line.dirty = true;
 }
 
+uint32_t CacheAbstract::read_across(uint32_t addr, uint32_t next, uint32_t size, AccessType type) {
+    if (type == AccessType::Instruction)
+        stats_.instr_access++;
+    else
+        stats_.data_access++;
+
+    stats_.misaligned_access++; // через границу страницы идут только невыровненные
+    return read_split(addr, next, size, type);
+}
+
+void CacheAbstract::write_across(uint32_t addr, uint32_t next, uint32_t value, uint32_t size) {
+    stats_.data_access++;
+    stats_.misaligned_access++;
+    write_split(addr, next, value, size);
+}
+
 // protected
 
+// Обращение через границу строки: два поиска, второй тоже считается
+// обращением (со своим hit/miss). Первая строка обрабатывается до выборки
+// второй, так что её вытеснение второй выборкой ничего не портит.
+// next - адрес второй строки: следующая строка или, при трансляции,
+// начало другой физической страницы.
+
+uint32_t CacheAbstract::read_split(uint32_t addr, uint32_t next, uint32_t size, AccessType type) {
+    stats_.split_access++;
+    if (type == AccessType::Instruction)
+        stats_.instr_access++;
+    else
+        stats_.data_access++;
+
+    const uint32_t first = CACHE_LINE_SIZE - addr_offset(addr);
+    uint8_t bytes[sizeof(uint32_t)];
+
+    Line& lo = fetch_line(addr, type);
+    if (sink_) record(addr, uint8_t(first), type, false);
+    std::memcpy(bytes, &lo.data[addr_offset(addr)], first);
+
+    Line& hi = fetch_line(next, type);
+    if (sink_) record(next, uint8_t(size - first), type, false);
+    std::memcpy(bytes + first, hi.data, size - first);
+
+    uint32_t value = 0;
+    std::memcpy(&value, bytes, size);
+    return value;
+}
+
+void CacheAbstract::write_split(uint32_t addr, uint32_t next, uint32_t value, uint32_t size) {
+    stats_.split_access++;
+    stats_.data_access++;
+
+    const uint32_t first = CACHE_LINE_SIZE - addr_offset(addr);
+    uint8_t bytes[sizeof(uint32_t)];
+    std::memcpy(bytes, &value, size);
+
+    Line& lo = fetch_line(addr, AccessType::Data);
+    if (sink_) record(addr, uint8_t(first), AccessType::Data, true);
+    std::memcpy(&lo.data[addr_offset(addr)], bytes, first);
+    lo.dirty = true;
+
+    Line& hi = fetch_line(next, AccessType::Data);
+    if (sink_) record(next, uint8_t(size - first), AccessType::Data, true);
+    std::memcpy(hi.data, bytes + first, size - first);
+    hi.dirty = true;
+}
+
+void CacheAbstract::record(uint32_t addr, uint8_t size, AccessType type, bool is_write) {
+    events_[event_count_++] = {addr, size, type, is_write, last_hit_};
+    if (event_count_ == ACCESS_EVENT_BATCH)
+        drain_events();
+}
+
 CacheAbstract::Line& CacheAbstract::fetch_line(uint32_t addr, AccessType type) {
+    PROFILE_SCOPE(FetchLine);
+
     const uint32_t set = addr_index(addr);
     const uint32_t tag = addr_tag(addr);
 
@@ -99,65 +224,109 @@ CacheAbstract::Line& CacheAbstract::fetch_line(uint32_t addr, AccessType type) {
                 stats_.data_hit++;
 
             on_hit(set, way);
+            last_hit_ = true;
+            if (mshr_) mshr_->access(line_base(addr), false);
             return line;
         }
     }
 
-    for (uint32_t way = 0; way < CACHE_WAY; ++way) {
-        if (!cache_[set][way].valid) {
-            Line& line = cache_[set][way];
-
-            uint32_t base = line_base(addr);
-            for (uint32_t i = 0; i < CACHE_LINE_SIZE; ++i)
-                line.data[i] = ram_.read8(base + i);
+    last_hit_ = false;
 
-            line.valid = true;
-            line.dirty = false;
-            line.tag = tag;
-
-            on_fill(set, way);
-            return line;
+    uint32_t way = CACHE_WAY;
+    for (uint32_t w = 0; w < CACHE_WAY; ++w) {
+        if (!cache_[set][w].valid) {
+            way = w;
+            break;
         }
     }
 
-    uint32_t way = choose_victim(set);
+    if (way == CACHE_WAY)
+        way = choose_victim(set);
+
     Line& line = cache_[set][way];
 
-    if (line.dirty) {
-        uint32_t base =
-            (line.tag << (CACHE_INDEX_LEN + CACHE_OFFSET_LEN)) |
-            (set << CACHE_OFFSET_LEN);
+    // Вытесняемая строка уходит в victim cache после того, как оттуда
+    // заберут запрошенную, иначе она могла бы вытеснить её саму
+    Line evicted;
+    bool to_victim = false;
+
+    if (line.valid) {
+        stats_.evictions++;
+
+        if (victim_) {
+            evicted = line;
+            to_victim = true;
+        } else if (line.dirty) {
+            stats_.writebacks++;
+            write_back(line_addr(line.tag, set), line.data);
+        }
+    }
+
+    const uint32_t base = line_base(addr);
+    bool dirty = false;
+    bool from_victim = victim_ && victim_->take(base, line.data, dirty);
 
+    if (!from_victim) {
         for (uint32_t i = 0; i < CACHE_LINE_SIZE; ++i)
-            ram_.write8(base + i, line.data[i]);
+            line.data[i] = ram_.read8(base + i);
     }
 
-    uint32_t base = line_base(addr);
-    for (uint32_t i = 0; i < CACHE_LINE_SIZE; ++i)
-        line.data[i] = ram_.read8(base + i);
+    if (to_victim) {
+        uint32_t spill_addr = 0;
+        uint8_t spill_data[CACHE_LINE_SIZE];
+        if (victim_->insert(line_addr(evicted.tag, set), evicted.data, evicted.dirty,
+                            spill_addr, spill_data)) {
+            stats_.writebacks++;
+            write_back(spill_addr, spill_data);
+        }
+    }
 
     line.valid = true;
-    line.dirty = false;
+    line.dirty = dirty;
     line.tag = tag;
 
+    if (mshr_) mshr_->access(base, !from_victim);
+
     on_fill(set, way);
     return line;
 }
 
+void CacheAbstract::write_back(uint32_t base, const uint8_t* data) {
+    for (uint32_t i = 0; i < CACHE_LINE_SIZE; ++i)
+        ram_.write8(base + i, data[i]);
+}
+
+void CacheAbstract::sync_to_ram() {
+    // строка не лежит одновременно в кеше и victim cache (take её забирает)
+    if (victim_)
+        victim_->for_each_dirty([this](uint32_t base, const uint8_t* data) { write_back(base, data); });
+
+    for (uint32_t set = 0; set < CACHE_SET_COUNT; ++set) {
+        for (uint32_t way = 0; way < CACHE_WAY; ++way) {
+            const Line& line = cache_[set][way];
+            if (line.valid && line.dirty)
+                write_back(line_addr(line.tag, set), line.data);
+        }
+    }
+}
+
 void CacheAbstract::flush() {
     for (uint32_t set = 0; set < CACHE_SET_COUNT; ++set) {
         for (uint32_t way = 0; way < CACHE_WAY; ++way) {
             Line& line = cache_[set][way];
             if (!line.valid || !line.dirty) continue;
 
-            uint32_t base =
-                (line.tag << (CACHE_INDEX_LEN + CACHE_OFFSET_LEN)) |
-                (set << CACHE_OFFSET_LEN);
-
-            for (uint32_t i = 0; i < CACHE_LINE_SIZE; ++i)
-                ram_.write8(base + i, line.data[i]);
+            write_back(line_addr(line.tag, set), line.data);
 
             line.dirty = false;
+            stats_.writebacks++;
         }
     }
+
+    if (victim_) {
+        victim_->flush([this](uint32_t base, const uint8_t* data) {
+            stats_.writebacks++;
+            write_back(base, data);
+        });
+    }
 }
@@ -0,0 +1,130 @@
+#include "interval_stats.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+static constexpr size_t INTERVAL_BUFFER_SIZE = 64 * 1024;
+static constexpr uint32_t INTERVAL_BINARY_VERSION = 1;
+
+// IntervalWriter
+
+IntervalWriter::IntervalWriter(const std::string& filename, IntervalFormat format)
+    : file_(std::fopen(filename.c_str(), "wb"))
+    , format_(format)
+    , buffer_(INTERVAL_BUFFER_SIZE)
+{
+    if (!file_) throw std::runtime_error("Cannot open interval output file");
+
+    if (format_ == IntervalFormat::Csv) {
+        static const char header[] =
+            "policy,interval,instructions,accesses,instr_access,instr_hit,"
+            "data_access,data_hit,evictions,writebacks\n";
+        append(header, sizeof(header) - 1);
+    } else {
+        append("RVIS", 4);
+        append(&INTERVAL_BINARY_VERSION, sizeof(INTERVAL_BINARY_VERSION));
+    }
+}
+
+IntervalWriter::~IntervalWriter() {
+    if (used_) std::fwrite(buffer_.data(), 1, used_, file_);
+    std::fclose(file_);
+}
+
+uint8_t IntervalWriter::add_policy(const std::string& name) {
+    if (policies_.size() > UINT8_MAX || name.size() > UINT8_MAX)
+        throw std::runtime_error("Too many interval policies");
+
+    uint8_t id = uint8_t(policies_.size());
+    policies_.push_back(name);
+
+    if (format_ == IntervalFormat::Binary) {
+        uint8_t head[3] = {1, id, uint8_t(name.size())};
+        append(head, sizeof(head));
+        append(name.data(), name.size());
+    }
+    return id;
+}
+
+void IntervalWriter::write(uint8_t policy, const IntervalSample& s) {
+    if (format_ == IntervalFormat::Csv) {
+        char line[256];
+        int n = std::snprintf(line, sizeof(line),
+            "%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n",
+            policies_[policy].c_str(),
+            (unsigned long long)s.index,
+            (unsigned long long)s.instructions,
+            (unsigned long long)s.accesses,
+            (unsigned long long)s.instr_access,
+            (unsigned long long)s.instr_hit,
+            (unsigned long long)s.data_access,
+            (unsigned long long)s.data_hit,
+            (unsigned long long)s.evictions,
+            (unsigned long long)s.writebacks);
+        append(line, size_t(n));
+    } else {
+        const uint64_t fields[] = {
+            s.index, s.instructions, s.accesses,
+            s.instr_access, s.instr_hit, s.data_access, s.data_hit,
+            s.evictions, s.writebacks
+        };
+        uint8_t head[2] = {2, policy};
+        append(head, sizeof(head));
+        append(fields, sizeof(fields));
+    }
+}
+
+void IntervalWriter::flush() {
+    if (used_ && std::fwrite(buffer_.data(), 1, used_, file_) != used_)
+        throw std::runtime_error("Cannot write interval output file");
+    used_ = 0;
+}
+
+void IntervalWriter::append(const void* data, size_t size) {
+    if (used_ + size > buffer_.size())
+        flush();
+    std::memcpy(buffer_.data() + used_, data, size);
+    used_ += size;
+}
+
+// IntervalRecorder
+
+IntervalRecorder::IntervalRecorder(IntervalWriter& writer, const std::string& policy,
+                                   IntervalUnit unit, uint64_t period)
+    : writer_(writer)
+    , policy_(writer.add_policy(policy))
+    , unit_(unit)
+    , period_(period)
+    , next_mark_(period)
+{
+    if (period == 0) throw std::runtime_error("Interval period must be positive");
+}
+
+void IntervalRecorder::finish(uint64_t retired, const CacheStats& s) {
+    uint64_t accesses = s.instr_access + s.data_access;
+    if (retired != last_instructions_ || accesses != last_.instr_access + last_.data_access ||
+        s.writebacks != last_.writebacks)
+        snapshot(retired, s);
+}
+
+void IntervalRecorder::snapshot(uint64_t retired, const CacheStats& s) {
+    IntervalSample sample;
+    sample.index = index_++;
+    sample.instructions = retired;
+    sample.accesses = s.instr_access + s.data_access;
+    sample.instr_access = s.instr_access - last_.instr_access;
+    sample.instr_hit = s.instr_hit - last_.instr_hit;
+    sample.data_access = s.data_access - last_.data_access;
+    sample.data_hit = s.data_hit - last_.data_hit;
+    sample.evictions = s.evictions - last_.evictions;
+    sample.writebacks = s.writebacks - last_.writebacks;
+
+    writer_.write(policy_, sample);
+
+    last_ = s;
+    last_instructions_ = retired;
+
+    uint64_t pos = unit_ == IntervalUnit::Instructions ? retired : sample.accesses;
+    while (next_mark_ <= pos)
+        next_mark_ += period_;
+}
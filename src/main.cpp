@@ -1,14 +1,20 @@
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <vector>
 #include <map>
+#include <memory>
 #include <string>
 #include <stdexcept>
 #include <cmath>
 
 #include "processor.hpp"
+#include "interval_stats.hpp"
+#include "self_profile.hpp"
+#include "result_writer.hpp"
 #include "cache_lru.hpp"
 #include "cache_bplru.hpp"
 #include "ram.hpp"
@@ -76,6 +82,148 @@ void print_stats(const char* name, const CacheStats& s) {
     );
 }
 
+void print_fusion_stats(const char* name, const Processor& cpu) {
+    FusionStats f = cpu.fusion_stats();
+    uint64_t fused = f.lui_addi + f.auipc_jalr + f.cmp_branch + f.slli_add;
+    uint64_t retired = cpu.retired();
+
+    double fused_rate = retired ? 100.0 * 2 * fused / retired : std::nan("");
+
+    std::printf(
+        "| %-11s | %12llu | %10.4f%% | %12llu | %12llu | %12llu | %12llu |\n",
+        name,
+        (unsigned long long)retired,
+        fused_rate,
+        (unsigned long long)f.lui_addi,
+        (unsigned long long)f.auipc_jalr,
+        (unsigned long long)f.cmp_branch,
+        (unsigned long long)f.slli_add
+    );
+}
+
+void print_access_stats(const char* name, const CacheStats& s) {
+    std::printf(
+        "| %-11s | %12llu | %12llu | %12llu | %12llu |\n",
+        name,
+        (unsigned long long)s.misaligned_access,
+        (unsigned long long)s.split_access,
+        (unsigned long long)s.evictions,
+        (unsigned long long)s.writebacks
+    );
+}
+
+void print_miss_path_stats(const char* name, const CacheAbstract& cache) {
+    const CacheStats& s = cache.stats();
+    uint64_t misses = s.instr_access + s.data_access - s.instr_hit - s.data_hit;
+
+    VictimStats v;
+    if (cache.victim_cache()) v = cache.victim_cache()->stats();
+    MshrStats m;
+    if (cache.mshr()) m = cache.mshr()->stats();
+
+    double victim_hit_rate = v.lookups ? 100.0 * v.hits / v.lookups : std::nan("");
+
+    std::printf(
+        "| %-11s | %12llu | %12llu | %11.4f%% | %12llu | %12llu | %12llu | %12llu |\n",
+        name,
+        (unsigned long long)misses,
+        (unsigned long long)v.hits,
+        victim_hit_rate,
+        (unsigned long long)m.allocations,
+        (unsigned long long)m.merges,
+        (unsigned long long)m.stall_cycles,
+        (unsigned long long)m.cycles
+    );
+}
+
+void print_branch_stats(const BranchUnit& unit, uint64_t instructions) {
+    const BranchStats& b = unit.stats();
+
+    double dir_accuracy = b.cond_branches ? 100.0 * (b.cond_branches - b.cond_mispredicts) / b.cond_branches : std::nan("");
+    double btb_hit_rate = b.btb_lookups ? 100.0 * b.btb_hits / b.btb_lookups : std::nan("");
+    double ras_hit_rate = b.returns ? 100.0 * b.ras_hits / b.returns : std::nan("");
+    double mpki = instructions ? 1000.0 * b.mispredicts() / instructions : std::nan("");
+
+    std::printf(
+        "| %-9s | %12llu | %11.4f%% | %12llu | %11.4f%% | %11.4f%% | %12llu | %9.4f |\n",
+        unit.name(),
+        (unsigned long long)b.cond_branches,
+        dir_accuracy,
+        (unsigned long long)b.jumps,
+        btb_hit_rate,
+        ras_hit_rate,
+        (unsigned long long)b.mispredicts(),
+        mpki
+    );
+}
+
+std::string host_counter(const HostCounters& c, HostEvent e) {
+    return c.has(e) ? std::to_string(c[e]) : "n/a";
+}
+
+void print_self_profile(const char* name, const HostCounters& c, const char* source,
+                        uint64_t instructions, const CacheStats& s) {
+    uint64_t accesses = s.instr_access + s.data_access;
+    uint64_t cycles = c[HostEvent::Cycles];
+
+    double per_instr = instructions ? double(cycles) / instructions : std::nan("");
+    double per_access = accesses ? double(cycles) / accesses : std::nan("");
+    double host_ipc = c.has(HostEvent::Instructions) && cycles ? double(c[HostEvent::Instructions]) / cycles : std::nan("");
+    double mips = c.seconds > 0 ? instructions / c.seconds / 1e6 : std::nan("");
+
+    std::printf(
+        "| %-11s | %-6s | %12llu | %9.2f | %10.2f | %8.3f | %12s | %12s | %12s | %8.2f |\n",
+        name,
+        source,
+        (unsigned long long)cycles,
+        per_instr,
+        per_access,
+        host_ipc,
+        host_counter(c, HostEvent::L1dMisses).c_str(),
+        host_counter(c, HostEvent::LlcMisses).c_str(),
+        host_counter(c, HostEvent::BranchMisses).c_str(),
+        mips
+    );
+}
+
+void print_profile_regions(const char* name, const ProfileRegions& regions, uint64_t total_ticks) {
+    for (size_t i = 0; i < PROFILE_REGION_COUNT; ++i) {
+        const RegionStats& r = regions[i];
+        std::printf(
+            "| %-11s | %-10s | %12llu | %14llu | %9.2f | %9.4f%% |\n",
+            name,
+            profile_region_name(ProfileRegion(i)),
+            (unsigned long long)r.calls,
+            (unsigned long long)r.ticks,
+            r.calls ? double(r.ticks) / r.calls : std::nan(""),
+            total_ticks ? 100.0 * r.ticks / total_ticks : std::nan("")
+        );
+    }
+}
+
+void print_tlb_stats(const char* name, const Mmu& mmu) {
+    const TlbStats& i = mmu.itlb().stats();
+    const TlbStats& d = mmu.dtlb().stats();
+    const PageWalkStats& w = mmu.walk_stats();
+
+    double itlb_hit_rate = i.lookups ? 100.0 * i.hits / i.lookups : std::nan("");
+    double dtlb_hit_rate = d.lookups ? 100.0 * d.hits / d.lookups : std::nan("");
+    double pte_hit_rate = w.pte_reads ? 100.0 * w.pte_read_hits / w.pte_reads : std::nan("");
+
+    std::printf(
+        "| %-11s | %12.4f%% | %12.4f%% | %12llu | %12llu | %12llu | %11.4f%% | %12llu | %12llu |\n",
+        name,
+        itlb_hit_rate,
+        dtlb_hit_rate,
+        (unsigned long long)w.walks,
+        (unsigned long long)w.pte_reads,
+        (unsigned long long)w.pte_read_hits,
+        pte_hit_rate,
+        (unsigned long long)w.superpages,
+        (unsigned long long)w.ad_updates
+    );
+}
+
 void load_memory(RAM& ram, const std::map<uint32_t, std::vector<uint8_t>>& memory) {
     for (const auto& [addr, data] : memory) {
         for (size_t i = 0; i < data.size(); ++i) {
@@ -87,32 +235,35 @@ void load_memory(RAM& ram, const std::map<uint32_t, std::vector<uint8_t>>& memor
 
 void write_output_file(const std::string& filename,
                        const Processor& cpu,
-                       RAM& ram,
+                       const RAM& ram,
                        uint32_t start_addr,
                        uint32_t size) {
     if (start_addr >= ram.size())
         throw std::runtime_error("Start address out of RAM bounds");
-    if (size == 0 || start_addr + size > ram.size())
+    if (size == 0 || size > ram.size() - start_addr)
         throw std::runtime_error("Memory size out of RAM bounds");
 
+    // cpu.run() уже сбросил кеш, RAM актуальна; файл собирается целиком
+    // и пишется одним вызовом
+    std::span<const uint32_t, 32> regs = cpu.regs();
+    std::span<const uint8_t> memory = ram.bytes().subspan(start_addr, size);
+
+    std::vector<char> buffer(regs.size_bytes() + 2 * sizeof(uint32_t) + memory.size());
+    char* p = buffer.data();
+    std::memcpy(p, regs.data(), regs.size_bytes());
+    p += regs.size_bytes();
+    std::memcpy(p, &start_addr, sizeof(start_addr));
+    p += sizeof(start_addr);
+    std::memcpy(p, &size, sizeof(size));
+    p += sizeof(size);
+    std::memcpy(p, memory.data(), memory.size());
+
     std::ofstream out(filename, std::ios::binary);
     if (!out)
         throw std::runtime_error("Cannot open output file");
 
-    for (int i = 0; i < 32; ++i) {
-        uint32_t val = cpu.get_reg(i);
-        out.write(reinterpret_cast<const char*>(&val), sizeof(val));
-    }
-
-    out.write(reinterpret_cast<const char*>(&start_addr), sizeof(start_addr));
-    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
-
-    for (uint32_t i = 0; i < size; ++i) {
-        uint8_t byte = ram.read8(start_addr + i);
-        out.write(reinterpret_cast<const char*>(&byte), sizeof(byte));
-    }
-
-    out.close();
+    if (!out.write(buffer.data(), std::streamsize(buffer.size())))
+        throw std::runtime_error("Cannot write output file");
 }
 
 int main(int argc, char* argv[]) {
@@ -121,6 +272,25 @@ int main(int argc, char* argv[]) {
         std::string output_file;
         uint32_t out_addr = 0, out_size = 0;
         bool has_output = false;
+        bool fusion = false;
+        bool fusion_stats = false;
+        bool access_stats = false;
+        bool self_profile = false;
+        std::string results_file;
+        ResultFormat results_format = ResultFormat::Ndjson;
+        uint32_t victim_entries = 0;
+        uint32_t mshr_entries = 0;
+        uint32_t miss_latency = MEMORY_MISS_LATENCY;
+        std::string bpred;
+        uint32_t btb_entries = BTB_ENTRIES;
+        uint32_t ras_depth = RAS_DEPTH;
+        bool mmu = false;
+        uint32_t page_table_root = 0;
+        TlbConfig itlb_config, dtlb_config;
+        uint64_t interval_period = 0;
+        IntervalUnit interval_unit = IntervalUnit::Instructions;
+        IntervalFormat interval_format = IntervalFormat::Csv;
+        std::string interval_file;
 
         for (int i = 1; i < argc; ++i) {
             std::string arg = argv[i];
@@ -133,6 +303,71 @@ int main(int argc, char* argv[]) {
                 out_addr = std::stoul(argv[++i], nullptr, 0); // поддержка 0x
                 out_size = std::stoul(argv[++i], nullptr, 0);
                 has_output = true;
+            } else if (arg == "--fusion") {
+                fusion = true;
+            } else if (arg == "--no-fusion") {
+                fusion = false;
+            } else if (arg == "--fusion-stats") {
+                fusion_stats = true;
+            } else if (arg == "--access-stats") {
+                access_stats = true;
+            } else if (arg == "--self-profile") {
+                self_profile = true;
+            } else if (arg == "--victim") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing entry count after --victim");
+                victim_entries = std::stoul(argv[++i], nullptr, 0);
+            } else if (arg == "--mshr") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing entry count after --mshr");
+                mshr_entries = std::stoul(argv[++i], nullptr, 0);
+            } else if (arg == "--miss-latency") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing cycles after --miss-latency");
+                miss_latency = std::stoul(argv[++i], nullptr, 0);
+            } else if (arg == "--bpred") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing predictor after --bpred");
+                bpred = argv[++i];
+            } else if (arg == "--btb") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing entry count after --btb");
+                btb_entries = std::stoul(argv[++i], nullptr, 0);
+            } else if (arg == "--ras") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing depth after --ras");
+                ras_depth = std::stoul(argv[++i], nullptr, 0);
+            } else if (arg == "--results") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing file after --results");
+                results_file = argv[++i];
+            } else if (arg == "--results-format") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing format after --results-format");
+                std::string format = argv[++i];
+                if (format == "ndjson") results_format = ResultFormat::Ndjson;
+                else if (format == "col") results_format = ResultFormat::Columnar;
+                else throw std::runtime_error("Unknown results format: " + format);
+            } else if (arg == "--mmu") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing page table root after --mmu");
+                page_table_root = std::stoul(argv[++i], nullptr, 0);
+                mmu = true;
+            } else if (arg == "--itlb" || arg == "--dtlb") {
+                if (i + 2 >= argc) throw std::runtime_error("Missing sets and ways after " + arg);
+                TlbConfig& tlb = arg == "--itlb" ? itlb_config : dtlb_config;
+                tlb.sets = std::stoul(argv[++i], nullptr, 0);
+                tlb.ways = std::stoul(argv[++i], nullptr, 0);
+            } else if (arg == "--tlb-policy") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing policy after --tlb-policy");
+                itlb_config.policy = dtlb_config.policy = argv[++i];
+            } else if (arg == "--interval") {
+                if (i + 2 >= argc) throw std::runtime_error("Missing arguments for --interval");
+                interval_period = std::stoull(argv[++i], nullptr, 0);
+                interval_file = argv[++i];
+            } else if (arg == "--interval-unit") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing unit after --interval-unit");
+                std::string unit = argv[++i];
+                if (unit == "instr") interval_unit = IntervalUnit::Instructions;
+                else if (unit == "access") interval_unit = IntervalUnit::Accesses;
+                else throw std::runtime_error("Unknown interval unit: " + unit);
+            } else if (arg == "--interval-format") {
+                if (i + 1 >= argc) throw std::runtime_error("Missing format after --interval-format");
+                std::string format = argv[++i];
+                if (format == "csv") interval_format = IntervalFormat::Csv;
+                else if (format == "bin") interval_format = IntervalFormat::Binary;
+                else throw std::runtime_error("Unknown interval format: " + format);
             } else {
                 throw std::runtime_error("Unknown argument: " + arg);
             }
@@ -140,19 +375,72 @@ int main(int argc, char* argv[]) {
 
         InputData input = read_input_file(input_file);
 
+        std::unique_ptr<IntervalWriter> interval_writer;
+        std::unique_ptr<IntervalRecorder> interval_lru, interval_bplru;
+        if (interval_period) {
+            interval_writer = std::make_unique<IntervalWriter>(interval_file, interval_format);
+            interval_lru = std::make_unique<IntervalRecorder>(
+                *interval_writer, "LRU", interval_unit, interval_period);
+            interval_bplru = std::make_unique<IntervalRecorder>(
+                *interval_writer, "bpLRU", interval_unit, interval_period);
+        }
+
+        // переходы не зависят от политики кеша, поэтому предсказатель
+        // подключается только к первому процессору
+        std::unique_ptr<BranchUnit> branch_unit;
+        if (!bpred.empty())
+            branch_unit = std::make_unique<BranchUnit>(make_direction_predictor(bpred), btb_entries, ras_depth);
+
+        // счётчики хоста охватывают только Processor::run()
+        std::unique_ptr<PerfCounters> perf;
+        if (self_profile)
+            perf = std::make_unique<PerfCounters>();
+        HostCounters host_lru, host_bplru;
+        ProfileRegions regions_lru, regions_bplru;
+
         RAM ram_lru(MEMORY_SIZE);
         load_memory(ram_lru, input.memory);
 
         CacheLRU cache_lru(ram_lru);
+        cache_lru.attach_victim_cache(victim_entries);
+        cache_lru.attach_mshr(mshr_entries, miss_latency);
         Processor cpu_lru(cache_lru, input.registers);
+        std::unique_ptr<Mmu> mmu_lru;
+        if (mmu) {
+            mmu_lru = std::make_unique<Mmu>(cache_lru, page_table_root, itlb_config, dtlb_config);
+            cpu_lru.set_mmu(mmu_lru.get());
+        }
+        cpu_lru.set_fusion_enabled(fusion);
+        cpu_lru.set_interval_recorder(interval_lru.get());
+        cpu_lru.set_branch_unit(branch_unit.get());
+        take_profile_regions();
+        if (perf) perf->start();
+        auto start_lru = std::chrono::steady_clock::now();
         cpu_lru.run();
+        double seconds_lru = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_lru).count();
+        if (perf) host_lru = perf->stop();
+        regions_lru = take_profile_regions();
 
         RAM ram_bplru(MEMORY_SIZE);
         load_memory(ram_bplru, input.memory);
 
         CacheBpLRU cache_bplru(ram_bplru);
+        cache_bplru.attach_victim_cache(victim_entries);
+        cache_bplru.attach_mshr(mshr_entries, miss_latency);
         Processor cpu_bplru(cache_bplru, input.registers);
+        std::unique_ptr<Mmu> mmu_bplru;
+        if (mmu) {
+            mmu_bplru = std::make_unique<Mmu>(cache_bplru, page_table_root, itlb_config, dtlb_config);
+            cpu_bplru.set_mmu(mmu_bplru.get());
+        }
+        cpu_bplru.set_fusion_enabled(fusion);
+        cpu_bplru.set_interval_recorder(interval_bplru.get());
+        if (perf) perf->start();
+        auto start_bplru = std::chrono::steady_clock::now();
         cpu_bplru.run();
+        double seconds_bplru = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_bplru).count();
+        if (perf) host_bplru = perf->stop();
+        regions_bplru = take_profile_regions();
 
         std::printf("| replacement | hit_rate | instr_hit_rate | data_hit_rate | instr_access |  instr_hit   | data_access  |   data_hit   |\n");
         std::printf("| :---------- | :------: | -------------: | ------------: | -----------: | -----------: | -----------: | -----------: |\n");
@@ -160,6 +448,105 @@ int main(int argc, char* argv[]) {
         print_stats("LRU", cache_lru.stats());
         print_stats("bpLRU", cache_bplru.stats());
 
+        if (mmu) {
+            std::printf("\n");
+            std::printf("| replacement | itlb_hit_rate | dtlb_hit_rate |  page_walks  |  pte_reads   |   pte_hits   | pte_hit_rate |  superpages  |  ad_updates  |\n");
+            std::printf("| :---------- | ------------: | ------------: | -----------: | -----------: | -----------: | -----------: | -----------: | -----------: |\n");
+
+            print_tlb_stats("LRU", *mmu_lru);
+            print_tlb_stats("bpLRU", *mmu_bplru);
+        }
+
+        if (branch_unit) {
+            std::printf("\n");
+            std::printf("| predictor |   branches   | dir_accuracy |    jumps     | btb_hit_rate | ras_hit_rate | mispredicts  |   MPKI    |\n");
+            std::printf("| :-------- | -----------: | -----------: | -----------: | -----------: | -----------: | -----------: | --------: |\n");
+
+            print_branch_stats(*branch_unit, cpu_lru.retired());
+        }
+
+        if (fusion_stats) {
+            std::printf("\n");
+            std::printf("| replacement |   retired    | fused_rate  |   lui_addi   |  auipc_jalr  |  cmp_branch  |   slli_add   |\n");
+            std::printf("| :---------- | -----------: | ----------: | -----------: | -----------: | -----------: | -----------: |\n");
+
+            print_fusion_stats("LRU", cpu_lru);
+            print_fusion_stats("bpLRU", cpu_bplru);
+        }
+
+        if (access_stats) {
+            std::printf("\n");
+            std::printf("| replacement |  misaligned  |    split     |  evictions   |  writebacks  |\n");
+            std::printf("| :---------- | -----------: | -----------: | -----------: | -----------: |\n");
+
+            print_access_stats("LRU", cache_lru.stats());
+            print_access_stats("bpLRU", cache_bplru.stats());
+        }
+
+        if (victim_entries || mshr_entries) {
+            std::printf("\n");
+            std::printf("| replacement |    misses    |  victim_hit  | victim_rate  | mshr_alloc   |  mshr_merge  | stall_cycles |    cycles    |\n");
+            std::printf("| :---------- | -----------: | -----------: | -----------: | -----------: | -----------: | -----------: | -----------: |\n");
+
+            print_miss_path_stats("LRU", cache_lru);
+            print_miss_path_stats("bpLRU", cache_bplru);
+        }
+
+        if (perf) {
+            const char* source = perf->available() ? "perf" : "tsc";
+
+            std::printf("\n");
+            std::printf("| replacement | source | host_cycles  | cyc/instr | cyc/access | host_IPC |   L1D_miss   |   LLC_miss   |   br_miss    |   MIPS   |\n");
+            std::printf("| :---------- | :----- | -----------: | --------: | ---------: | -------: | -----------: | -----------: | -----------: | -------: |\n");
+
+            print_self_profile("LRU", host_lru, source, cpu_lru.retired(), cache_lru.stats());
+            print_self_profile("bpLRU", host_bplru, source, cpu_bplru.retired(), cache_bplru.stats());
+
+            if (SELF_PROFILE_PROBES) {
+                std::printf("\n");
+                std::printf("| replacement | region     |    calls     |   tsc_ticks    | per_call  |   share    |\n");
+                std::printf("| :---------- | :--------- | -----------: | -------------: | --------: | ---------: |\n");
+
+                print_profile_regions("LRU", regions_lru, host_lru.timestamp_ticks);
+                print_profile_regions("bpLRU", regions_bplru, host_bplru.timestamp_ticks);
+            }
+        }
+
+        if (!results_file.empty()) {
+            ResultWriter results(results_file, results_format);
+
+            auto add_row = [&](const char* policy, const Processor& cpu, const CacheAbstract& cache, double seconds) {
+                const CacheStats& s = cache.stats();
+                results.begin_row();
+                results.field("input", input_file);
+                results.field("policy", policy);
+                results.field("fusion", uint64_t(fusion));
+                results.field("victim_entries", uint64_t(victim_entries));
+                results.field("mshr_entries", uint64_t(mshr_entries));
+                results.field("miss_latency", uint64_t(miss_latency));
+                results.field("bpred", bpred);
+                results.field("mmu", uint64_t(mmu));
+                results.field("retired", cpu.retired());
+                results.field("instr_access", s.instr_access);
+                results.field("instr_hit", s.instr_hit);
+                results.field("data_access", s.data_access);
+                results.field("data_hit", s.data_hit);
+                results.field("evictions", s.evictions);
+                results.field("writebacks", s.writebacks);
+                results.field("misaligned_access", s.misaligned_access);
+                results.field("split_access", s.split_access);
+                results.field("seconds", seconds);
+                results.end_row();
+            };
+
+            add_row("LRU", cpu_lru, cache_lru, seconds_lru);
+            add_row("bpLRU", cpu_bplru, cache_bplru, seconds_bplru);
+            results.write();
+        }
+
+        if (interval_writer)
+            interval_writer->flush();
+
         if (has_output)
             write_output_file(output_file, cpu_lru, ram_lru, out_addr, out_size);
 
@@ -0,0 +1,185 @@
+#include "mmu.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+
+// Биты PTE Sv32
+static constexpr uint32_t PTE_V = 1u << 0;
+static constexpr uint32_t PTE_R = 1u << 1;
+static constexpr uint32_t PTE_W = 1u << 2;
+static constexpr uint32_t PTE_X = 1u << 3;
+static constexpr uint32_t PTE_A = 1u << 6;
+static constexpr uint32_t PTE_D = 1u << 7;
+
+static constexpr uint32_t VPN_LEN = 10;
+static constexpr uint32_t PPN_LEN = 22;
+
+// Tlb
+
+Tlb::Tlb(const TlbConfig& config)
+    : entries_(size_t(config.sets) * config.ways)
+    , policy_(make_replacement_policy(config.policy, config.sets, config.ways))
+    , set_mask_(config.sets - 1)
+    , ways_(config.ways)
+{
+    if (config.sets & (config.sets - 1))
+        throw std::runtime_error("TLB set count must be a power of two");
+}
+
+Tlb::Entry* Tlb::lookup(uint32_t vpn) {
+    stats_.lookups++;
+
+    uint32_t set = vpn & set_mask_;
+    Entry* ways = &entries_[set * ways_];
+
+    for (uint32_t way = 0; way < ways_; ++way) {
+        if (ways[way].valid && ways[way].vpn == vpn) {
+            stats_.hits++;
+            policy_->on_hit(set, way);
+            return &ways[way];
+        }
+    }
+    return nullptr;
+}
+
+Tlb::Entry& Tlb::insert(const Entry& entry) {
+    uint32_t set = entry.vpn & set_mask_;
+    Entry* ways = &entries_[set * ways_];
+
+    // обновление прав/D у уже закешированной страницы
+    for (uint32_t way = 0; way < ways_; ++way) {
+        if (ways[way].valid && ways[way].vpn == entry.vpn) {
+            ways[way] = entry;
+            ways[way].valid = true;
+            policy_->on_hit(set, way);
+            return ways[way];
+        }
+    }
+
+    uint32_t victim = ways_;
+    for (uint32_t way = 0; way < ways_; ++way) {
+        if (!ways[way].valid) {
+            victim = way;
+            break;
+        }
+    }
+
+    if (victim == ways_) {
+        victim = policy_->choose_victim(set);
+        stats_.evictions++;
+    }
+
+    ways[victim] = entry;
+    ways[victim].valid = true;
+    policy_->on_fill(set, victim);
+    return ways[victim];
+}
+
+void Tlb::flush() {
+    for (Entry& e : entries_)
+        e.valid = false;
+    stats_.flushes++;
+}
+
+// Mmu
+
+Mmu::Mmu(CacheAbstract& cache, uint32_t root, const TlbConfig& itlb, const TlbConfig& dtlb)
+    : cache_(cache)
+    , root_(root)
+    , itlb_(itlb)
+    , dtlb_(dtlb)
+{
+    if (root & (PAGE_SIZE - 1))
+        throw std::runtime_error("Page table root must be page aligned");
+}
+
+void Mmu::flush_tlbs() {
+    itlb_.flush();
+    dtlb_.flush();
+}
+
+bool Mmu::permitted(const Tlb::Entry& e, MmuAccess access) {
+    switch (access) {
+        case MmuAccess::Fetch: return e.perms & PTE_X;
+        case MmuAccess::Load: return e.perms & PTE_R;
+        case MmuAccess::Store: return (e.perms & PTE_W) && e.dirty;
+    }
+    return false;
+}
+
+Tlb::Entry* Mmu::walk(Tlb& tlb, uint32_t vaddr, MmuAccess access) {
+    walk_stats_.walks++;
+
+    const uint32_t vpn[2] = {
+        (vaddr >> PAGE_OFFSET_LEN) & ((1u << VPN_LEN) - 1),
+        vaddr >> (PAGE_OFFSET_LEN + VPN_LEN)
+    };
+
+    uint32_t table = root_;
+
+    for (int level = 1; level >= 0; --level) {
+        uint32_t pte_addr = table + vpn[level] * 4;
+        uint32_t pte = read_pte(pte_addr);
+
+        if (!(pte & PTE_V) || (!(pte & PTE_R) && (pte & PTE_W)))
+            page_fault(vaddr, access, "invalid PTE");
+
+        uint32_t ppn = pte >> (32 - PPN_LEN);
+        if (ppn >> (32 - PAGE_OFFSET_LEN))
+            page_fault(vaddr, access, "physical address above 4 GB");
+
+        if (!(pte & (PTE_R | PTE_X))) { // указатель на следующий уровень
+            if (level == 0)
+                page_fault(vaddr, access, "no leaf PTE");
+            table = ppn << PAGE_OFFSET_LEN;
+            continue;
+        }
+
+        if (level == 1) { // мегастраница 4 МБ
+            if (ppn & ((1u << VPN_LEN) - 1))
+                page_fault(vaddr, access, "misaligned superpage");
+            ppn |= vpn[0];
+            walk_stats_.superpages++;
+        }
+
+        Tlb::Entry e;
+        e.vpn = vaddr >> PAGE_OFFSET_LEN;
+        e.ppn = ppn;
+        e.perms = uint8_t(pte & (PTE_R | PTE_W | PTE_X));
+        e.dirty = true; // D выставим ниже, здесь проверяется только W
+
+        if (!permitted(e, access))
+            page_fault(vaddr, access, "permission denied");
+
+        // A/D выставляются аппаратно (как в Svadu)
+        uint32_t updated = pte | PTE_A | (access == MmuAccess::Store ? PTE_D : 0);
+        if (updated != pte) {
+            cache_.write32(pte_addr, updated);
+            walk_stats_.ad_updates++;
+        }
+        e.dirty = updated & PTE_D;
+
+        return &tlb.insert(e);
+    }
+
+    page_fault(vaddr, access, "no leaf PTE");
+}
+
+uint32_t Mmu::read_pte(uint32_t addr) {
+    uint64_t hits_before = cache_.stats().data_hit;
+    uint32_t pte = cache_.read32(addr, AccessType::Data);
+
+    walk_stats_.pte_reads++;
+    if (cache_.stats().data_hit != hits_before)
+        walk_stats_.pte_read_hits++;
+    return pte;
+}
+
+void Mmu::page_fault(uint32_t vaddr, MmuAccess access, const char* reason) {
+    static const char* const names[] = {"fetch", "load", "store"};
+
+    char message[128];
+    std::snprintf(message, sizeof(message), "Page fault on %s at 0x%08x: %s",
+                  names[size_t(access)], vaddr, reason);
+    throw std::runtime_error(message);
+}
@@ -0,0 +1,36 @@
+#include "mshr.hpp"
+
+#include <stdexcept>
+
+MshrFile::MshrFile(uint32_t entries, uint32_t miss_latency)
+    : entries_(entries)
+    , miss_latency_(miss_latency)
+{
+    if (entries == 0) throw std::runtime_error("MSHR file needs at least one entry");
+}
+
+void MshrFile::access(uint32_t line_addr, bool memory_miss) {
+    uint64_t now = ++stats_.cycles;
+
+    Entry* earliest = &entries_[0];
+    for (Entry& e : entries_) {
+        if (e.ready > now && e.line_addr == line_addr) {
+            stats_.merges++;
+            return;
+        }
+        if (e.ready < earliest->ready)
+            earliest = &e;
+    }
+
+    if (!memory_miss) return;
+
+    if (earliest->ready > now) {
+        stats_.full_stalls++;
+        stats_.stall_cycles += earliest->ready - now;
+        now = stats_.cycles = earliest->ready;
+    }
+
+    earliest->line_addr = line_addr;
+    earliest->ready = now + miss_latency_;
+    stats_.allocations++;
+}
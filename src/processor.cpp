@@ -1,45 +1,101 @@
 #include "processor.hpp"
 
-Processor::Processor(CacheAbstract& cache, const std::vector<uint32_t>& regs) 
+#include <algorithm>
+
+#include "self_profile.hpp"
+
+Processor::Processor(CacheAbstract& cache, std::span<const uint32_t> regs) 
     : cache_(cache)
-    , regs_(regs)
-    , pc_(regs_[0])
-    , start_ra_(regs[1]) {
+{
+    if (regs.size() != regs_.size())
+        throw std::runtime_error("Processor expects 32 registers");
+
+    std::copy(regs.begin(), regs.end(), regs_.begin());
+    pc_ = regs_[0];
+    start_ra_ = regs_[1];
+    regs_[0] = 0; // во входных данных x0 хранит pc
 }
 
 void Processor::run() {
-    do {
-        uint32_t instr = cache_.read32(pc_, AccessType::Instruction);
+    while (!halted_)
+        step();
+
+    cache_.flush();
 
-        Command cmd = parse(instr);
+    if (interval_)
+        interval_->finish(retired_, cache_.stats());
+}
+
+uint32_t Processor::step(bool allow_fusion) {
+    Command cmd;
+    {
+        PROFILE_SCOPE(Decode);
+
+        if (has_pending_) {
+            cmd = pending_;
+            has_pending_ = false;
+        } else {
+            cmd = parse(fetch(pc_));
+        }
 
         validate_opcode(cmd);  // Проверка валидности opcode/funct
+    }
 
-        auto f = get_function(cmd);
-        f(cmd, *this);
+    PROFILE_SCOPE(Execute);
 
-        pc_ += 4;
-        
-    } while (pc_ != start_ra_);
+    uint32_t executed = 1;
 
-    cache_.flush();
+    // Голова пары не трогает память и pc, поэтому выборка хвоста до её
+    // исполнения даёт ту же последовательность обращений к кешу
+    if (allow_fusion && fusion_enabled_ && is_fusion_head(cmd) && pc_ + 4 != start_ra_) {
+        Command tail = parse(fetch(pc_ + 4));
+
+        FusedIdiom idiom = match_fusion(cmd, tail);
+        if (idiom != FusedIdiom::None) {
+            exec_fused(idiom, cmd, tail);
+            executed = 2;
+        } else {
+            pending_ = tail;
+            has_pending_ = true;
+        }
+    }
+
+    if (executed == 1)
+        (this->*get_function(cmd))(cmd);
+
+    retired_ += executed;
+    if (interval_)
+        interval_->tick(retired_, cache_.stats());
+
+    pc_ += 4;
+    halted_ = pc_ == start_ra_;
+    return executed;
 }
 
 uint32_t Processor::read_mem(uint32_t addr, uint32_t size, bool is_signed) {
     uint32_t value = 0;
 
-    switch (size) {
-        case 1: 
-            value = cache_.read8(addr, AccessType::Data); 
-            break;
-        case 2: 
-            value = cache_.read16(addr, AccessType::Data);
-            break;
-        case 4:
-            value = cache_.read32(addr, AccessType::Data);
-            break;
-        default: 
-            throw std::runtime_error("Invalid memory size");
+    if (crosses_page(addr, size)) [[unlikely]] {
+        uint32_t lo = mmu_->translate(addr, MmuAccess::Load);
+        uint32_t hi = mmu_->translate(next_page(addr), MmuAccess::Load);
+        value = cache_.read_across(lo, hi, size, AccessType::Data);
+    } else {
+        if (mmu_)
+            addr = mmu_->translate(addr, MmuAccess::Load);
+
+        switch (size) {
+            case 1: 
+                value = cache_.read8(addr, AccessType::Data); 
+                break;
+            case 2: 
+                value = cache_.read16(addr, AccessType::Data);
+                break;
+            case 4:
+                value = cache_.read32(addr, AccessType::Data);
+                break;
+            default: 
+                throw std::runtime_error("Invalid memory size");
+        }
     }
 
     if (is_signed) {
@@ -54,6 +110,17 @@ uint32_t Processor::read_mem(uint32_t addr, uint32_t size, bool is_signed) {
 }
 
 void Processor::write_mem(uint32_t addr, uint32_t value, uint32_t size) {
+    if (crosses_page(addr, size)) [[unlikely]] {
+        // обе трансляции до записи, чтобы page fault не оставил половину записи
+        uint32_t lo = mmu_->translate(addr, MmuAccess::Store);
+        uint32_t hi = mmu_->translate(next_page(addr), MmuAccess::Store);
+        cache_.write_across(lo, hi, value, size);
+        return;
+    }
+
+    if (mmu_)
+        addr = mmu_->translate(addr, MmuAccess::Store);
+
     switch (size) {
         case 1: 
             cache_.write8(addr, value & 0xFF); 
@@ -126,23 +193,61 @@ void Processor::validate_opcode(const Command& c) {
     }
 }
 
+bool Processor::is_fusion_head(const Command& c) {
+    switch (c.opcode) {
+        case 0x37: case 0x17: return true;                      // LUI, AUIPC
+        case 0x13: return c.funct3 == 0x1 || c.funct3 == 0x2 || c.funct3 == 0x3; // SLLI, SLTI, SLTIU
+        case 0x33: return c.funct7 == 0x00 && (c.funct3 == 0x2 || c.funct3 == 0x3); // SLT, SLTU
+        default: return false;
+    }
+}
+
+FusedIdiom Processor::match_fusion(const Command& h, const Command& t) {
+    if (h.rd == 0) return FusedIdiom::None;
+
+    switch (h.opcode) {
+        case 0x37: // LUI + ADDI
+            if (t.opcode == 0x13 && t.funct3 == 0x0 && t.rs1 == h.rd)
+                return FusedIdiom::LuiAddi;
+            break;
+        case 0x17: // AUIPC + JALR
+            if (t.opcode == 0x67 && t.rs1 == h.rd)
+                return FusedIdiom::AuipcJalr;
+            break;
+        case 0x13:
+            if (h.funct3 == 0x1) { // SLLI + ADD
+                if (t.opcode == 0x33 && t.funct3 == 0x0 && t.funct7 == 0x00 &&
+                    (t.rs1 == h.rd || t.rs2 == h.rd))
+                    return FusedIdiom::SlliAdd;
+                break;
+            }
+            [[fallthrough]];
+        case 0x33: // SLT* + BEQ/BNE rd, x0
+            if (t.opcode == 0x63 && (t.funct3 == 0x0 || t.funct3 == 0x1) &&
+                ((t.rs1 == h.rd && t.rs2 == 0) || (t.rs2 == h.rd && t.rs1 == 0)))
+                return FusedIdiom::CmpBranch;
+            break;
+    }
+    return FusedIdiom::None;
+}
+
 void Processor::write_reg(uint8_t rd, uint32_t value) {
     regs_[rd] = value;
     regs_[0] = 0;
 }
 
-std::function<void(Command&, Processor&)> Processor::get_function(const Command& cmd) {
+Processor::Handler Processor::get_function(const Command& cmd) {
     switch (cmd.opcode) {
-        case 0x33: return [this](Command& c, Processor& p){ p.exec_r_type(c); };
-        case 0x03: return [this](Command& c, Processor& p){ p.exec_load(c); };
-        case 0x13: return [this](Command& c, Processor& p){ p.exec_imm_arith(c); };
-        case 0x23: return [this](Command& c, Processor& p){ p.exec_store(c); };
-        case 0x63: return [this](Command& c, Processor& p){ p.exec_branch(c); };
-        case 0x73: return [this](Command& c, Processor& p){ p.exec_system(c); };
-        case 0x17: return [this](Command& c, Processor& p){ p.exec_auipc(c); };
-        case 0x37: return [this](Command& c, Processor& p){ p.exec_lui(c); };
-        case 0x6F: return [this](Command& c, Processor& p){ p.exec_jal(c); };
-        case 0x67: return [this](Command& c, Processor& p){ p.exec_jalr(c); };
+        case 0x33: return &Processor::exec_r_type;
+        case 0x03: return &Processor::exec_load;
+        case 0x13: return &Processor::exec_imm_arith;
+        case 0x23: return &Processor::exec_store;
+        case 0x63: return &Processor::exec_branch;
+        case 0x73: return &Processor::exec_system;
+        case 0x17: return &Processor::exec_auipc;
+        case 0x37: return &Processor::exec_lui;
+        case 0x6F: return &Processor::exec_jal;
+        case 0x67: return &Processor::exec_jalr;
         default: break;
     }
     throw std::runtime_error("End of get_function method in Processor");
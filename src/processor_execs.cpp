@@ -1,38 +1,66 @@
 #include "processor.hpp"
 
 void Processor::exec_r_type(Command& c) {
+    if (c.funct7 == 0x01) {
+        exec_mul_div(c);
+        return;
+    }
+
     switch (c.funct3) {
         case 0x0:
-            if (c.funct7 == 0x01) { // MUL
-                uint64_t res = uint64_t(uint32_t(regs_[c.rs1])) * uint64_t(uint32_t(regs_[c.rs2]));
-                write_reg(c.rd, static_cast<uint32_t>(res & 0xFFFFFFFF));
-            }
+            if (c.funct7 == 0x20) write_reg(c.rd, regs_[c.rs1] - regs_[c.rs2]); // SUB
+            else write_reg(c.rd, regs_[c.rs1] + regs_[c.rs2]);                   // ADD
+            break;
+        case 0x1: write_reg(c.rd, regs_[c.rs1] << (regs_[c.rs2] & 0x1F)); break;              // SLL
+        case 0x2: write_reg(c.rd, int32_t(regs_[c.rs1]) < int32_t(regs_[c.rs2])); break;      // SLT
+        case 0x3: write_reg(c.rd, regs_[c.rs1] < regs_[c.rs2]); break;                        // SLTU
+        case 0x4: write_reg(c.rd, regs_[c.rs1] ^ regs_[c.rs2]); break;                        // XOR
+        case 0x5:
+            if (c.funct7 == 0x20) write_reg(c.rd, int32_t(regs_[c.rs1]) >> (regs_[c.rs2] & 0x1F)); // SRA
+            else write_reg(c.rd, regs_[c.rs1] >> (regs_[c.rs2] & 0x1F));                           // SRL
+            break;
+        case 0x6: write_reg(c.rd, regs_[c.rs1] | regs_[c.rs2]); break;                        // OR
+        case 0x7: write_reg(c.rd, regs_[c.rs1] & regs_[c.rs2]); break;                        // AND
+    }
+}
+
+void Processor::exec_mul_div(Command& c) {
+    switch (c.funct3) {
+        case 0x0: { // MUL
+            uint64_t res = uint64_t(uint32_t(regs_[c.rs1])) * uint64_t(uint32_t(regs_[c.rs2]));
+            write_reg(c.rd, static_cast<uint32_t>(res & 0xFFFFFFFF));
             break;
-        case 0x1:
-            if (c.funct7 == 0x01) { // MULH
-                int64_t res = int64_t(int32_t(regs_[c.rs1])) * int64_t(int32_t(regs_[c.rs2]));
-                write_reg(c.rd, static_cast<uint32_t>((res >> 32) & 0xFFFFFFFF));
-            }
+        }
+        case 0x1: { // MULH
+            int64_t res = int64_t(int32_t(regs_[c.rs1])) * int64_t(int32_t(regs_[c.rs2]));
+            write_reg(c.rd, static_cast<uint32_t>((res >> 32) & 0xFFFFFFFF));
             break;
-        case 0x4:
-            if (c.funct7 == 0x01) { // DIV
-                write_reg(c.rd, regs_[c.rs2] ? int32_t(regs_[c.rs1]) / int32_t(regs_[c.rs2]) : -1);
-            }
+        }
+        case 0x2: { // MULHSU
+            int64_t res = int64_t(int32_t(regs_[c.rs1])) * int64_t(uint64_t(regs_[c.rs2]));
+            write_reg(c.rd, static_cast<uint32_t>((res >> 32) & 0xFFFFFFFF));
             break;
-        case 0x5:
-            if (c.funct7 == 0x01) { // DIVU
-                write_reg(c.rd, regs_[c.rs2] ? regs_[c.rs1] / regs_[c.rs2] : 0xFFFFFFFF);
-            }
+        }
+        case 0x3: { // MULHU
+            uint64_t res = uint64_t(regs_[c.rs1]) * uint64_t(regs_[c.rs2]);
+            write_reg(c.rd, static_cast<uint32_t>(res >> 32));
+            break;
+        }
+        case 0x4: // DIV
+            if (regs_[c.rs2] == 0) write_reg(c.rd, -1);
+            else if (regs_[c.rs1] == 0x80000000 && regs_[c.rs2] == 0xFFFFFFFF) write_reg(c.rd, regs_[c.rs1]);
+            else write_reg(c.rd, int32_t(regs_[c.rs1]) / int32_t(regs_[c.rs2]));
+            break;
+        case 0x5: // DIVU
+            write_reg(c.rd, regs_[c.rs2] ? regs_[c.rs1] / regs_[c.rs2] : 0xFFFFFFFF);
             break;
-        case 0x6:
-            if (c.funct7 == 0x01) { // REM
-                write_reg(c.rd, regs_[c.rs2] ? int32_t(regs_[c.rs1]) % int32_t(regs_[c.rs2]) : regs_[c.rs1]);
-            }
+        case 0x6: // REM
+            if (regs_[c.rs2] == 0) write_reg(c.rd, regs_[c.rs1]);
+            else if (regs_[c.rs1] == 0x80000000 && regs_[c.rs2] == 0xFFFFFFFF) write_reg(c.rd, 0);
+            else write_reg(c.rd, int32_t(regs_[c.rs1]) % int32_t(regs_[c.rs2]));
             break;
-        case 0x7:
-            if (c.funct7 == 0x01) { // REMU
-                write_reg(c.rd, regs_[c.rs2] ? regs_[c.rs1] % regs_[c.rs2] : regs_[c.rs1]);
-            }
+        case 0x7: // REMU
+            write_reg(c.rd, regs_[c.rs2] ? regs_[c.rs1] % regs_[c.rs2] : regs_[c.rs1]);
             break;
     }
 }
@@ -83,12 +111,15 @@ void Processor::exec_branch(Command& c) {
         case 0x6: take = regs_[c.rs1] < regs_[c.rs2]; break; // BLTU
         case 0x7: take = regs_[c.rs1] >= regs_[c.rs2]; break; // BGEU
     }
+    if (branch_) branch_->on_branch(pc_, pc_ + c.imm, take);
     if (take) pc_ += c.imm - 4;
 }
 
 void Processor::exec_system(Command& c) {
     if (c.funct3 == 0x0 && (c.funct12 == 0x0 || c.funct12 == 0x1)) {
         pc_ = start_ra_ - 4; // ECALL/EBREAK
+    } else if (c.funct3 == 0x0 && c.funct7 == 0x09 && c.rd == 0) {
+        if (mmu_) mmu_->flush_tlbs(); // SFENCE.VMA, адрес и ASID не различаются
     }
 }
 
@@ -101,6 +132,7 @@ void Processor::exec_auipc(Command& c) {
 }
 
 void Processor::exec_jal(Command& c) { 
+    if (branch_) branch_->on_jal(pc_, pc_ + c.imm, c.rd);
     write_reg(c.rd, pc_ + 4); 
     pc_ += c.imm - 4; 
 }
@@ -108,6 +140,57 @@ void Processor::exec_jal(Command& c) {
 void Processor::exec_jalr(Command& c) { 
     uint32_t tmp = pc_ + 4; 
     pc_ = (regs_[c.rs1] + c.imm) & ~1; 
+    if (branch_) branch_->on_jalr(tmp - 4, pc_, c.rd, c.rs1);
     write_reg(c.rd, tmp);
     pc_ -= 4;
 }
+
+// Слитые пары: голова и хвост исполняются за один вызов, pc_ в конце
+// указывает на хвост (как после обычного exec_*, +4 делает run())
+
+void Processor::exec_fused(FusedIdiom idiom, Command& h, Command& t) {
+    switch (idiom) {
+        case FusedIdiom::LuiAddi:
+            write_reg(h.rd, h.imm);
+            write_reg(t.rd, uint32_t(h.imm) + t.imm);
+            pc_ += 4;
+            fusion_stats_.lui_addi++;
+            break;
+
+        case FusedIdiom::AuipcJalr: {
+            uint32_t base = pc_ + h.imm;
+            write_reg(h.rd, base);
+            pc_ += 4;
+            uint32_t link = pc_ + 4;
+            uint32_t target = (base + t.imm) & ~1u;
+            if (branch_) branch_->on_jalr(pc_, target, t.rd, t.rs1);
+            pc_ = target - 4;
+            write_reg(t.rd, link);
+            fusion_stats_.auipc_jalr++;
+            break;
+        }
+
+        case FusedIdiom::CmpBranch: {
+            uint32_t a = regs_[h.rs1];
+            uint32_t b = h.opcode == 0x13 ? uint32_t(h.imm) : regs_[h.rs2];
+            uint32_t res = h.funct3 == 0x2 ? int32_t(a) < int32_t(b) : a < b;
+            write_reg(h.rd, res);
+            pc_ += 4;
+            bool take = t.funct3 == 0x0 ? res == 0 : res != 0; // BEQ / BNE против x0
+            if (branch_) branch_->on_branch(pc_, pc_ + t.imm, take);
+            if (take) pc_ += t.imm - 4;
+            fusion_stats_.cmp_branch++;
+            break;
+        }
+
+        case FusedIdiom::SlliAdd:
+            write_reg(h.rd, regs_[h.rs1] << (h.imm & 0x1F));
+            write_reg(t.rd, regs_[t.rs1] + regs_[t.rs2]);
+            pc_ += 4;
+            fusion_stats_.slli_add++;
+            break;
+
+        default:
+            throw std::runtime_error("Unknown fused idiom");
+    }
+}
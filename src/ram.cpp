@@ -6,7 +6,7 @@
 
 RAM::RAM(uint32_t size)
     : size_(size),
-      data_(new uint8_t[size])
+      data_(new uint8_t[size]())
 {}
 
 RAM::~RAM() {
@@ -0,0 +1,112 @@
+#include "replacement_policy.hpp"
+
+#include <stdexcept>
+
+// ReplacementPolicy
+
+ReplacementPolicy::ReplacementPolicy(uint32_t sets, uint32_t ways)
+    : sets_(sets)
+    , ways_(ways)
+{
+    if (sets == 0 || ways == 0)
+        throw std::runtime_error("Replacement policy needs at least one set and one way");
+    if (ways > 256)
+        throw std::runtime_error("Replacement policy supports at most 256 ways");
+}
+
+// LruPolicy
+
+LruPolicy::LruPolicy(uint32_t sets, uint32_t ways)
+    : ReplacementPolicy(sets, ways)
+    , last_used_(size_t(sets) * ways)
+{
+    for (uint32_t set = 0; set < sets_; ++set) {
+        for (uint32_t way = 0; way < ways_; ++way) {
+            last_used_[set * ways_ + way] = way;
+        }
+    }
+}
+
+uint32_t LruPolicy::choose_victim(uint32_t set) {
+    const uint8_t* ranks = &last_used_[set * ways_];
+    for (uint32_t way = 0; way < ways_; ++way) {
+        if (ranks[way] == ways_ - 1)
+            return way;
+    }
+    return 0;
+}
+
+void LruPolicy::on_hit(uint32_t set, uint32_t way) {
+    uint8_t* ranks = &last_used_[set * ways_];
+    uint8_t old = ranks[way];
+
+    for (uint32_t w = 0; w < ways_; ++w) {
+        if (ranks[w] < old)
+            ranks[w]++;
+    }
+
+    ranks[way] = 0;
+}
+
+void LruPolicy::on_fill(uint32_t set, uint32_t way) {
+    uint8_t* ranks = &last_used_[set * ways_];
+
+    for (uint32_t w = 0; w < ways_; ++w) {
+        ranks[w]++;
+    }
+
+    ranks[way] = 0;
+}
+
+// BpLruPolicy
+
+BpLruPolicy::BpLruPolicy(uint32_t sets, uint32_t ways)
+    : ReplacementPolicy(sets, ways)
+    , used_(size_t(sets) * ways, 0)
+{}
+
+uint32_t BpLruPolicy::choose_victim(uint32_t set) {
+    uint8_t* used = &used_[set * ways_];
+    for (uint32_t way = 0; way < ways_; ++way) {
+        if (!used[way])
+            return way;
+    }
+
+    for (uint32_t way = 0; way < ways_; ++way) {
+        used[way] = false;
+    }
+
+    uint32_t victim = 0;
+    used[victim] = true;
+    return victim;
+}
+
+void BpLruPolicy::on_hit(uint32_t set, uint32_t way) {
+    uint8_t* used = &used_[set * ways_];
+    used[way] = true;
+
+    bool all_used = true;
+    for (uint32_t w = 0; w < ways_; ++w) {
+        if (!used[w]) {
+            all_used = false;
+            break;
+        }
+    }
+
+    if (all_used) {
+        for (uint32_t w = 0; w < ways_; ++w)
+            used[w] = false;
+
+        used[way] = true;
+    }
+}
+
+void BpLruPolicy::on_fill(uint32_t set, uint32_t way) {
+    on_hit(set, way);
+}
+
+std::unique_ptr<ReplacementPolicy> make_replacement_policy(const std::string& name, uint32_t sets, uint32_t ways) {
+    if (name == "lru") return std::make_unique<LruPolicy>(sets, ways);
+    if (name == "bplru") return std::make_unique<BpLruPolicy>(sets, ways);
+    throw std::runtime_error("Unknown replacement policy: " + name);
+}
@@ -0,0 +1,226 @@
+#include "result_writer.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr uint32_t RESULT_COLUMNAR_VERSION = 1;
+
+static void put_bytes(std::vector<char>& out, const void* data, size_t size) {
+    if (size == 0) return;
+    size_t used = out.size();
+    out.resize(used + size);
+    std::memcpy(out.data() + used, data, size);
+}
+
+template <typename T>
+static void put(std::vector<char>& out, T value) {
+    put_bytes(out, &value, sizeof(value));
+}
+
+static void put_varint(std::vector<char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+static uint64_t zigzag(int64_t value) {
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+// ctor
+
+ResultWriter::ResultWriter(std::string filename, ResultFormat format)
+    : filename_(std::move(filename))
+    , format_(format)
+{}
+
+// Строки
+
+void ResultWriter::begin_row() {
+    if (in_row_) throw std::runtime_error("Result row is already open");
+    in_row_ = true;
+    column_ = 0;
+
+    if (format_ == ResultFormat::Ndjson)
+        json_ += '{';
+}
+
+void ResultWriter::end_row() {
+    if (!in_row_) throw std::runtime_error("No open result row");
+    if (column_ != columns_.size())
+        throw std::runtime_error("Result row has fewer fields than the schema");
+
+    in_row_ = false;
+    schema_fixed_ = true;
+    rows_++;
+
+    if (format_ == ResultFormat::Ndjson)
+        json_ += "}\n";
+}
+
+ResultWriter::Column& ResultWriter::next_column(std::string_view name, ColumnType type) {
+    if (!in_row_) throw std::runtime_error("Result field outside of a row");
+
+    if (!schema_fixed_) {
+        if (columns_.size() > UINT16_MAX || name.size() > UINT8_MAX)
+            throw std::runtime_error("Result schema is too large");
+        columns_.push_back({std::string(name), type, {}, {}, {}, {}});
+    }
+
+    if (column_ >= columns_.size() || columns_[column_].name != name || columns_[column_].type != type)
+        throw std::runtime_error("Result field does not match the schema: " + std::string(name));
+
+    return columns_[column_++];
+}
+
+void ResultWriter::json_key(std::string_view name) {
+    if (column_ > 1) json_ += ',';
+    json_ += '"';
+    json_ += name;
+    json_ += "\":";
+}
+
+void ResultWriter::field(std::string_view name, uint64_t value) {
+    Column& c = next_column(name, ColumnType::U64);
+
+    if (format_ == ResultFormat::Ndjson) {
+        json_key(name);
+        json_ += std::to_string(value);
+    } else {
+        c.u64.push_back(value);
+    }
+}
+
+void ResultWriter::field(std::string_view name, double value) {
+    Column& c = next_column(name, ColumnType::F64);
+
+    if (format_ == ResultFormat::Ndjson) {
+        json_key(name);
+        if (std::isfinite(value)) {
+            char buf[32];
+            int n = std::snprintf(buf, sizeof(buf), "%.9g", value);
+            json_.append(buf, size_t(n));
+        } else {
+            json_ += "null";
+        }
+    } else {
+        c.f64.push_back(value);
+    }
+}
+
+void ResultWriter::field(std::string_view name, std::string_view value) {
+    Column& c = next_column(name, ColumnType::String);
+
+    if (format_ == ResultFormat::Ndjson) {
+        json_key(name);
+        json_ += '"';
+        for (char ch : value) {
+            if (ch == '"' || ch == '\\') {
+                json_ += '\\';
+                json_ += ch;
+            } else if (uint8_t(ch) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", unsigned(uint8_t(ch)));
+                json_ += buf;
+            } else {
+                json_ += ch;
+            }
+        }
+        json_ += '"';
+        return;
+    }
+
+    // значения в свипе повторяются (политика, имя входа), словарь короткий
+    uint32_t id = 0;
+    while (id < c.dict.size() && c.dict[id] != value)
+        ++id;
+    if (id == c.dict.size())
+        c.dict.emplace_back(value);
+    c.ids.push_back(id);
+}
+
+// Запись
+
+std::vector<char> ResultWriter::encode_block() const {
+    std::vector<char> block;
+    put<uint32_t>(block, 0); // размер, заполняется в конце
+    put<uint32_t>(block, rows_);
+    put<uint16_t>(block, uint16_t(columns_.size()));
+
+    std::vector<char> data;
+    for (const Column& c : columns_) {
+        data.clear();
+
+        switch (c.type) {
+            case ColumnType::U64: {
+                uint64_t prev = 0;
+                for (uint64_t v : c.u64) {
+                    put_varint(data, zigzag(int64_t(v - prev)));
+                    prev = v;
+                }
+                break;
+            }
+            case ColumnType::F64:
+                put_bytes(data, c.f64.data(), c.f64.size() * sizeof(double));
+                break;
+            case ColumnType::String:
+                put_varint(data, c.dict.size());
+                for (const std::string& s : c.dict) {
+                    put_varint(data, s.size());
+                    put_bytes(data, s.data(), s.size());
+                }
+                for (uint32_t id : c.ids)
+                    put_varint(data, id);
+                break;
+        }
+
+        put<uint8_t>(block, uint8_t(c.name.size()));
+        put_bytes(block, c.name.data(), c.name.size());
+        put<uint8_t>(block, uint8_t(c.type));
+        put<uint32_t>(block, uint32_t(data.size()));
+        put_bytes(block, data.data(), data.size());
+    }
+
+    uint32_t size = uint32_t(block.size() - sizeof(uint32_t));
+    std::memcpy(block.data(), &size, sizeof(size));
+    return block;
+}
+
+void ResultWriter::write() {
+    if (in_row_) throw std::runtime_error("Result row is still open");
+    if (rows_ == 0) return;
+
+    std::FILE* file = std::fopen(filename_.c_str(), "ab");
+    if (!file) throw std::runtime_error("Cannot open results file");
+
+    std::vector<char> block;
+    if (format_ == ResultFormat::Columnar) {
+        std::fseek(file, 0, SEEK_END);
+        if (std::ftell(file) == 0) {
+            put_bytes(block, "RVRC", 4);
+            put(block, RESULT_COLUMNAR_VERSION);
+        }
+        std::vector<char> rows = encode_block();
+        put_bytes(block, rows.data(), rows.size());
+    }
+
+    const char* data = format_ == ResultFormat::Ndjson ? json_.data() : block.data();
+    size_t size = format_ == ResultFormat::Ndjson ? json_.size() : block.size();
+
+    bool ok = std::fwrite(data, 1, size, file) == size;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) throw std::runtime_error("Cannot write results file");
+
+    json_.clear();
+    for (Column& c : columns_) {
+        c.u64.clear();
+        c.f64.clear();
+        c.ids.clear();
+        c.dict.clear();
+    }
+    rows_ = 0;
+}
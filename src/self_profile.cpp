@@ -0,0 +1,125 @@
+#include "self_profile.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+#ifdef __linux__
+
+static int open_event(uint32_t type, uint64_t config, int group_fd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group_fd < 0; // группа включается через лидера
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    return int(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+static constexpr uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+#endif
+
+PerfCounters::PerfCounters() {
+    fds_.fill(-1);
+    slot_.fill(-1);
+
+#ifdef __linux__
+    struct EventConfig {
+        uint32_t type;
+        uint64_t config;
+    };
+
+    const EventConfig events[HOST_EVENT_COUNT] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+
+    // лидер - такты; без него группа не имеет смысла
+    leader_ = open_event(events[0].type, events[0].config, -1);
+    if (leader_ < 0) return;
+
+    fds_[0] = leader_;
+    slot_[0] = 0;
+    opened_ = 1;
+
+    // отдельные события могут отсутствовать (например, LLC в виртуалке)
+    for (size_t i = 1; i < HOST_EVENT_COUNT; ++i) {
+        int fd = open_event(events[i].type, events[i].config, leader_);
+        if (fd < 0) continue;
+        fds_[i] = fd;
+        slot_[i] = int(opened_++);
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds_) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+    if (available()) {
+        ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+    start_time_ = std::chrono::steady_clock::now();
+    start_ticks_ = host_timestamp();
+}
+
+HostCounters PerfCounters::stop() {
+    HostCounters c;
+    c.timestamp_ticks = host_timestamp() - start_ticks_;
+    c.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+
+#ifdef __linux__
+    if (available()) {
+        ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // PERF_FORMAT_GROUP: u64 nr, затем nr значений
+        uint64_t buffer[1 + HOST_EVENT_COUNT] = {};
+        ssize_t n = read(leader_, buffer, sizeof(buffer));
+
+        if (n >= ssize_t(sizeof(uint64_t)) && buffer[0] == opened_) {
+            for (size_t i = 0; i < HOST_EVENT_COUNT; ++i) {
+                if (slot_[i] < 0) continue;
+                c.values[i] = buffer[1 + slot_[i]];
+                c.valid[i] = true;
+            }
+            return c;
+        }
+    }
+#endif
+
+    c.values[size_t(HostEvent::Cycles)] = c.timestamp_ticks;
+    c.valid[size_t(HostEvent::Cycles)] = true;
+    return c;
+}
+
+const char* profile_region_name(ProfileRegion region) {
+    switch (region) {
+        case ProfileRegion::Decode: return "decode";
+        case ProfileRegion::Execute: return "execute";
+        case ProfileRegion::FetchLine: return "fetch_line";
+        default: return "?";
+    }
+}
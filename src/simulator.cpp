@@ -0,0 +1,57 @@
+#include "simulator.hpp"
+
+#include <stdexcept>
+
+#include "cache_bplru.hpp"
+#include "cache_lru.hpp"
+#include "config.hpp"
+
+static std::unique_ptr<CacheAbstract> make_cache(CachePolicy policy, RAM& ram) {
+    switch (policy) {
+        case CachePolicy::LRU: return std::make_unique<CacheLRU>(ram);
+        case CachePolicy::BpLRU: return std::make_unique<CacheBpLRU>(ram);
+    }
+    throw std::runtime_error("Unknown cache policy");
+}
+
+static RAM& load_image(RAM& ram, std::span<const MemorySegment> image) {
+    for (const MemorySegment& seg : image) {
+        if (seg.addr > ram.size() || seg.data.size() > ram.size() - seg.addr)
+            throw std::runtime_error("Memory address out of range");
+
+        for (size_t i = 0; i < seg.data.size(); ++i)
+            ram.write8(seg.addr + i, seg.data[i]);
+    }
+    return ram;
+}
+
+// ctor
+
+Simulator::Simulator(std::span<const uint32_t> regs,
+                     std::span<const MemorySegment> image,
+                     CachePolicy policy)
+    : ram_(MEMORY_SIZE)
+    , cache_(make_cache(policy, load_image(ram_, image)))
+    , cpu_(*cache_, regs)
+{}
+
+// Public API
+
+uint64_t Simulator::step(uint64_t n) {
+    uint64_t executed = 0;
+    while (executed < n && !cpu_.halted())
+        executed += cpu_.step(n - executed > 1);
+
+    cache_->drain_events();
+    return executed;
+}
+
+void Simulator::enable_mmu(uint32_t root, const TlbConfig& itlb, const TlbConfig& dtlb) {
+    mmu_ = std::make_unique<Mmu>(*cache_, root, itlb, dtlb);
+    cpu_.set_mmu(mmu_.get());
+}
+
+std::span<const uint8_t> Simulator::memory() {
+    cache_->sync_to_ram();
+    return ram_.bytes();
+}
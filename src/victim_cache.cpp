@@ -0,0 +1,54 @@
+#include "victim_cache.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+VictimCache::VictimCache(uint32_t entries)
+    : entries_(entries)
+{
+    if (entries == 0) throw std::runtime_error("Victim cache needs at least one entry");
+}
+
+bool VictimCache::take(uint32_t line_addr, uint8_t* data, bool& dirty) {
+    stats_.lookups++;
+
+    for (Entry& e : entries_) {
+        if (e.valid && e.line_addr == line_addr) {
+            std::memcpy(data, e.data, CACHE_LINE_SIZE);
+            dirty = e.dirty;
+            e.valid = false;
+            stats_.hits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VictimCache::insert(uint32_t line_addr, const uint8_t* data, bool dirty,
+                         uint32_t& spill_addr, uint8_t* spill_data) {
+    stats_.inserts++;
+
+    Entry* slot = &entries_[0];
+    for (Entry& e : entries_) {
+        if (!e.valid) {
+            slot = &e;
+            break;
+        }
+        if (e.last_use < slot->last_use)
+            slot = &e;
+    }
+
+    bool spill = slot->valid && slot->dirty;
+    if (spill) {
+        spill_addr = slot->line_addr;
+        std::memcpy(spill_data, slot->data, CACHE_LINE_SIZE);
+        stats_.writebacks++;
+    }
+
+    std::memcpy(slot->data, data, CACHE_LINE_SIZE);
+    slot->line_addr = line_addr;
+    slot->last_use = ++clock_;
+    slot->valid = true;
+    slot->dirty = dirty;
+    return spill;
+}